@@ -1,5 +1,8 @@
 #pragma once
 
+/* toolchain */
+#include <concepts>
+
 namespace Coral
 {
 
@@ -31,4 +34,75 @@ class NoopLock : public ContextLock<NoopLock>
     }
 };
 
+/* Lock policies that hold no state and lock for their own lifetime. */
+template <class T>
+concept context_lock = std::derived_from<T, ContextLock<T>>;
+
+/* Lock policies with per-instance state (see Locks.h). */
+template <class T>
+concept instance_lock = (not context_lock<T>) && requires(T &lock) {
+    lock.lock();
+    lock.unlock();
+};
+
+/**
+ * Holds an instance lock for the lifetime of this object.
+ */
+template <instance_lock T> class ScopedLock
+{
+  public:
+    ScopedLock(T &_lock) : lock(_lock)
+    {
+        lock.lock();
+    }
+
+    ~ScopedLock()
+    {
+        lock.unlock();
+    }
+
+    ScopedLock(const ScopedLock &) = delete;
+    ScopedLock &operator=(const ScopedLock &) = delete;
+
+  protected:
+    T &lock;
+};
+
+/**
+ * A lock policy as stored by a buffer. Instance locks are members of the
+ * buffer (so each buffer can be locked independently), while context locks
+ * are only constructed for each critical section.
+ *
+ * \tparam T The lock policy.
+ */
+template <class T> class InstanceLock
+{
+  public:
+    using Guard = ScopedLock<T>;
+
+    inline Guard guard(void)
+    {
+        return Guard(policy);
+    }
+
+    inline T &get(void)
+    {
+        return policy;
+    }
+
+  protected:
+    T policy;
+};
+
+template <context_lock T> class InstanceLock<T>
+{
+  public:
+    using Guard = T;
+
+    inline Guard guard(void)
+    {
+        return Guard();
+    }
+};
+
 } // namespace Coral
@@ -0,0 +1,228 @@
+/**
+ * \file
+ * \brief Lock policies with per-instance state.
+ */
+#pragma once
+
+/* toolchain */
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/* internal */
+#include "ContextLock.h"
+
+namespace Coral
+{
+
+/* Hint to the processor that the caller is busy-waiting. */
+inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+/* Number of busy-wait iterations before a waiter yields its time slice. */
+static constexpr uint32_t spin_limit = 128;
+
+/* Busy-wait briefly, then yield (in case the holder isn't running). */
+inline void spin_wait(uint32_t &spins)
+{
+    if (spins < spin_limit)
+    {
+        spins++;
+        cpu_relax();
+    }
+    else
+    {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * Optional lock-acquisition counters. Only updated by the thread holding the
+ * lock, but may be read from any thread.
+ *
+ * \tparam enabled Whether or not counters are kept.
+ */
+template <bool enabled> class LockMetrics
+{
+  public:
+    inline void record(bool contended)
+    {
+        (void)contended;
+    }
+
+    inline uint64_t acquisitions(void) const
+    {
+        return 0;
+    }
+
+    inline uint64_t contended(void) const
+    {
+        return 0;
+    }
+};
+
+template <> class LockMetrics<true>
+{
+  public:
+    inline void record(bool contended)
+    {
+        increment(acquired);
+        if (contended)
+        {
+            increment(waited);
+        }
+    }
+
+    /* Total number of times the lock was acquired. */
+    inline uint64_t acquisitions(void) const
+    {
+        return acquired.load(std::memory_order_relaxed);
+    }
+
+    /* Number of acquisitions that had to wait for another holder. */
+    inline uint64_t contended(void) const
+    {
+        return waited.load(std::memory_order_relaxed);
+    }
+
+  protected:
+    std::atomic<uint64_t> acquired = 0;
+    std::atomic<uint64_t> waited = 0;
+
+    /* Writers are serialized by the lock itself. */
+    static inline void increment(std::atomic<uint64_t> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    }
+};
+
+/**
+ * A test-and-test-and-set spinlock. Waiters spin on a plain load so that
+ * the cache line isn't written until the lock looks free.
+ */
+template <bool metrics = false> class SpinLock : public LockMetrics<metrics>
+{
+  public:
+    /* Blocked threads park (see \ref LockWaiter). */
+    static constexpr bool parks = true;
+
+    inline bool try_lock(void)
+    {
+        bool result = not flag.load(std::memory_order_relaxed) and
+                      not flag.exchange(true, std::memory_order_acquire);
+        if (result)
+        {
+            this->record(false);
+        }
+        return result;
+    }
+
+    inline void lock(void)
+    {
+        bool contended = false;
+        uint32_t spins = 0;
+
+        while (flag.exchange(true, std::memory_order_acquire))
+        {
+            contended = true;
+            while (flag.load(std::memory_order_relaxed))
+            {
+                spin_wait(spins);
+            }
+        }
+
+        this->record(contended);
+    }
+
+    inline void unlock(void)
+    {
+        flag.store(false, std::memory_order_release);
+    }
+
+  protected:
+    std::atomic<bool> flag = false;
+};
+
+/**
+ * A FIFO (fair) ticket lock.
+ */
+template <bool metrics = false> class TicketLock : public LockMetrics<metrics>
+{
+  public:
+    /* Blocked threads park (see \ref LockWaiter). */
+    static constexpr bool parks = true;
+
+    inline void lock(void)
+    {
+        auto ticket = next.fetch_add(1, std::memory_order_relaxed);
+        bool contended = false;
+        uint32_t spins = 0;
+
+        while (serving.load(std::memory_order_acquire) != ticket)
+        {
+            contended = true;
+            spin_wait(spins);
+        }
+
+        this->record(contended);
+    }
+
+    inline void unlock(void)
+    {
+        serving.store(serving.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+    }
+
+  protected:
+    std::atomic<uint32_t> next = 0;
+    std::atomic<uint32_t> serving = 0;
+};
+
+/**
+ * A lock policy backed by std::mutex (sleeps rather than spins).
+ */
+template <bool metrics = false> class MutexLock : public LockMetrics<metrics>
+{
+  public:
+    /* Blocked threads park (see \ref LockWaiter). */
+    static constexpr bool parks = true;
+
+    inline bool try_lock(void)
+    {
+        bool result = mutex.try_lock();
+        if (result)
+        {
+            this->record(false);
+        }
+        return result;
+    }
+
+    inline void lock(void)
+    {
+        bool contended = not mutex.try_lock();
+        if (contended)
+        {
+            mutex.lock();
+        }
+
+        this->record(contended);
+    }
+
+    inline void unlock(void)
+    {
+        mutex.unlock();
+    }
+
+  protected:
+    std::mutex mutex;
+};
+
+} // namespace Coral
@@ -0,0 +1,74 @@
+/* toolchain */
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+/* linux */
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* internal */
+#include "Waiter.h"
+
+namespace Coral
+{
+
+#ifdef __linux__
+
+void park(std::atomic<uint32_t> &word, uint32_t expected,
+          std::chrono::nanoseconds timeout)
+{
+    static_assert(sizeof(word) == sizeof(uint32_t));
+
+    struct timespec relative = {};
+    struct timespec *relative_ptr = nullptr;
+
+    if (timeout >= timeout.zero())
+    {
+        auto seconds =
+            std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        relative.tv_sec = seconds.count();
+        relative.tv_nsec = (timeout - seconds).count();
+        relative_ptr = &relative;
+    }
+
+    /* Returns early (EAGAIN, EINTR, ETIMEDOUT) for any reason to re-check. */
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+            FUTEX_WAIT_PRIVATE, expected, relative_ptr, nullptr, 0);
+}
+
+void unpark_all(std::atomic<uint32_t> &word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+            FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#else
+
+void park(std::atomic<uint32_t> &word, uint32_t expected,
+          std::chrono::nanoseconds timeout)
+{
+    if (timeout < timeout.zero())
+    {
+        word.wait(expected, std::memory_order_acquire);
+    }
+    else
+    {
+        /* std::atomic::wait has no timeout, sleep for (part of) it instead. */
+        std::this_thread::sleep_for(
+            std::min(timeout, std::chrono::nanoseconds(100000)));
+    }
+}
+
+void unpark_all(std::atomic<uint32_t> &word)
+{
+    word.notify_all();
+}
+
+#endif
+
+} // namespace Coral
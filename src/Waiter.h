@@ -0,0 +1,164 @@
+/**
+ * \file
+ * \brief A primitive for parking threads until a condition may have changed.
+ */
+#pragma once
+
+/* toolchain */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+/* internal */
+#include "Locks.h"
+
+namespace Coral
+{
+
+/**
+ * Block until \p word no longer holds \p expected, it's woken or \p timeout
+ * elapses (negative waits indefinitely). May return spuriously.
+ */
+void park(std::atomic<uint32_t> &word, uint32_t expected,
+          std::chrono::nanoseconds timeout);
+
+/* Wake every thread parked on \p word. */
+void unpark_all(std::atomic<uint32_t> &word);
+
+/**
+ * Lets threads sleep until some condition (e.g. data available in a buffer)
+ * becomes true, rather than spinning on it.
+ *
+ * Waiters spin briefly, then register themselves and sleep on an epoch
+ * counter. Notifiers only bump the epoch (and make a system call) when a
+ * waiter is registered, so notifying with no one waiting costs a fence and a
+ * load.
+ */
+class Waiter
+{
+  public:
+    static constexpr std::chrono::nanoseconds forever{-1};
+
+    /**
+     * Wait until a predicate holds.
+     *
+     * \param[in] ready   Predicate to wait on. Must observe state that is
+     *                    updated before a corresponding \ref notify.
+     * \param[in] timeout How long to wait (forever by default).
+     * \return            Whether or not the predicate held (false if the
+     *                    timeout elapsed first).
+     */
+    template <typename Predicate>
+    bool wait(Predicate ready, std::chrono::nanoseconds timeout = forever)
+    {
+        for (uint32_t spins = 0; spins < spin_limit; spins++)
+        {
+            if (ready())
+            {
+                return true;
+            }
+            cpu_relax();
+        }
+
+        using clock = std::chrono::steady_clock;
+        auto deadline = clock::now() + timeout;
+        bool result = ready();
+
+        while (not result)
+        {
+            auto remaining = forever;
+            if (timeout >= timeout.zero())
+            {
+                remaining = deadline - clock::now();
+                if (remaining <= remaining.zero())
+                {
+                    break;
+                }
+            }
+
+            auto current = epoch.load(std::memory_order_acquire);
+            waiters.fetch_add(1, std::memory_order_relaxed);
+
+            /* Pairs with the fence in notify. */
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            result = ready();
+            if (not result)
+            {
+                park(epoch, current, remaining);
+                result = ready();
+            }
+
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        return result;
+    }
+
+    /* Wake all waiters (call after updating the state they wait on). */
+    inline void notify(void)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (waiters.load(std::memory_order_relaxed))
+        {
+            epoch.fetch_add(1, std::memory_order_release);
+            unpark_all(epoch);
+        }
+    }
+
+  protected:
+    std::atomic<uint32_t> epoch = 0;
+    std::atomic<uint32_t> waiters = 0;
+};
+
+/**
+ * A \ref Waiter for state that no other thread could notify about (e.g. it's
+ * only touched by one thread and interrupt handlers). Waiting polls the
+ * predicate, and notifying compiles away.
+ */
+class PollingWaiter
+{
+  public:
+    template <typename Predicate>
+    bool wait(Predicate ready,
+              std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        using clock = std::chrono::steady_clock;
+        auto deadline = clock::now() + timeout;
+        uint32_t spins = 0;
+        bool result = ready();
+
+        while (not result)
+        {
+            if (timeout >= timeout.zero() and clock::now() >= deadline)
+            {
+                break;
+            }
+            spin_wait(spins);
+            result = ready();
+        }
+
+        return result;
+    }
+
+    inline void notify(void)
+    {
+        ;
+    }
+};
+
+/*
+ * Lock policies that share state between threads, which opt in to parking
+ * with a static 'parks' member.
+ */
+template <class T>
+concept parking_lock = requires { requires T::parks; };
+
+/* How buffers using a lock policy wait (and notify). */
+template <class Lock>
+using LockWaiter =
+    std::conditional_t<parking_lock<Lock>, Waiter, PollingWaiter>;
+
+} // namespace Coral
@@ -0,0 +1,35 @@
+#pragma once
+
+/* toolchain */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/*
+ * Minimal benchmark helpers (these apps print results, they don't assert on
+ * timing).
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+template <typename Callable> double bench_seconds(Callable &&callable)
+{
+    auto start = BenchClock::now();
+    callable();
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+inline void bench_report(const char *name, uint64_t operations,
+                         double seconds)
+{
+    std::printf("%-40s %12llu ops %10.3f ms %10.2f ns/op %10.2f Mops/s\n",
+                name, static_cast<unsigned long long>(operations),
+                seconds * 1e3, seconds * 1e9 / operations,
+                operations / seconds / 1e6);
+}
+
+/* Keep the optimizer from discarding benchmarked results. */
+template <typename T> inline void bench_keep(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
@@ -0,0 +1,96 @@
+/* toolchain */
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/* internal */
+#include "bench.h"
+#include "buffer/BroadcastBuffer.h"
+#include "buffer/SpscBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t depth = 4096;
+static constexpr std::size_t consumers = 3;
+static constexpr std::size_t chunk = 64;
+static constexpr uint64_t chunks = 200000;
+
+using Copies = std::array<SpscBuffer<depth, uint8_t>, consumers>;
+using Broadcast = BroadcastBuffer<depth, uint8_t, consumers>;
+
+/* Drain chunks on a thread per consumer while the caller writes. */
+template <typename Pop> double run(Pop pop, auto write)
+{
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < consumers; i++)
+    {
+        threads.emplace_back([pop, i]() {
+            std::array<uint8_t, chunk> out;
+            uint64_t total = 0;
+            for (uint64_t n = 0; n < chunks; n++)
+            {
+                pop(i, out);
+                total += out[0];
+            }
+            bench_keep(total);
+        });
+    }
+
+    double seconds = bench_seconds([&write]() {
+        std::array<uint8_t, chunk> data = {};
+        for (uint64_t n = 0; n < chunks; n++)
+        {
+            data[0] = static_cast<uint8_t>(n);
+            write(data);
+        }
+    });
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    return seconds;
+}
+
+int main(void)
+{
+    {
+        auto copies = std::make_unique<Copies>();
+        double seconds = run(
+            [&copies](std::size_t i, std::array<uint8_t, chunk> &out) {
+                (*copies)[i].pop_n_blocking(out.data(), out.size());
+            },
+            [&copies](const std::array<uint8_t, chunk> &data) {
+                for (auto &copy : *copies)
+                {
+                    copy.push_n_blocking(data.data(), data.size());
+                }
+            });
+        bench_report("fan-out, spsc copy per consumer", chunks, seconds);
+        std::printf("storage: %zu bytes\n", sizeof(Copies));
+    }
+
+    {
+        auto broadcast = std::make_unique<Broadcast>();
+        std::array<Broadcast::Reader *, consumers> readers;
+        for (auto &reader : readers)
+        {
+            reader = broadcast->attach();
+        }
+
+        double seconds = run(
+            [&readers](std::size_t i, std::array<uint8_t, chunk> &out) {
+                readers[i]->pop_n_blocking(out.data(), out.size());
+            },
+            [&broadcast](const std::array<uint8_t, chunk> &data) {
+                broadcast->push_n_blocking(data.data(), data.size());
+            });
+        bench_report("fan-out, broadcast", chunks, seconds);
+        std::printf("storage: %zu bytes\n", sizeof(Broadcast));
+    }
+
+    return 0;
+}
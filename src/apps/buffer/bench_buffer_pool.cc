@@ -0,0 +1,63 @@
+/* toolchain */
+#include <cstdio>
+#include <memory>
+
+/* internal */
+#include "bench.h"
+#include "buffer/BufferPool.h"
+#include "buffer/PcBuffer.h"
+
+using namespace Coral;
+
+static constexpr uint64_t iterations = 2000000;
+
+/* Simulate per-connection buffers: a few live, constantly replaced. */
+static constexpr std::size_t live = 16;
+
+using Buffer = PcBuffer<4096, uint8_t>;
+
+int main(void)
+{
+    {
+        std::array<std::unique_ptr<Buffer>, live> buffers;
+
+        double seconds = bench_seconds([&buffers]() {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                auto &buf = buffers[i % live];
+                buf = std::make_unique<Buffer>();
+                buf->push(static_cast<uint8_t>(i));
+                bench_keep(buf.get());
+            }
+        });
+        bench_report("heap (make_unique)", iterations, seconds);
+    }
+
+    {
+        BufferPool pool(sizeof(Buffer), live + 1);
+        std::array<BufferPool::Handle<Buffer>, live> buffers;
+
+        double seconds = bench_seconds([&buffers, &pool]() {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                auto &buf = buffers[i % live];
+                buf = pool.make<Buffer>();
+                buf->push(static_cast<uint8_t>(i));
+                bench_keep(buf.get());
+            }
+        });
+        bench_report("pool (make)", iterations, seconds);
+
+        for (auto &buf : buffers)
+        {
+            buf.reset();
+        }
+
+        BufferPoolStats stats = pool.stats();
+        std::printf("pool: %zu / %zu slabs peak, %llu cache hits\n",
+                    stats.high_watermark, stats.slab_count,
+                    static_cast<unsigned long long>(stats.cache_hits));
+    }
+
+    return 0;
+}
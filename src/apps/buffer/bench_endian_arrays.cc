@@ -0,0 +1,82 @@
+/* toolchain */
+#include <cstdio>
+#include <vector>
+
+/* internal */
+#include "bench.h"
+#include "buffer/CircularBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t depth = 4096;
+static constexpr std::size_t samples = 1000;
+static constexpr std::size_t rounds = 20000;
+
+using Buffer = CircularBuffer<depth>;
+
+template <typename T> void run(const char *type_name)
+{
+    static constexpr auto endianness = std::endian::big;
+
+    std::vector<T> values(samples);
+    for (std::size_t i = 0; i < samples; i++)
+    {
+        values[i] = static_cast<T>(i);
+    }
+    std::vector<T> compare(samples);
+
+    Buffer buf;
+    char name[64];
+
+    /* The odd-sized header keeps the ring wrapping at different offsets. */
+    double seconds = bench_seconds([&]() {
+        for (std::size_t round = 0; round < rounds; round++)
+        {
+            buf.write_single(std::byte{0});
+            for (auto value : values)
+            {
+                buf.write<endianness, T>(value);
+            }
+            buf.read_single();
+            for (auto &value : compare)
+            {
+                value = buf.read<endianness, T>();
+            }
+            bench_keep(compare[0]);
+        }
+    });
+    std::snprintf(name, sizeof name, "per-element %s", type_name);
+    bench_report(name, samples * rounds, seconds);
+
+    seconds = bench_seconds([&]() {
+        for (std::size_t round = 0; round < rounds; round++)
+        {
+            buf.write_single(std::byte{0});
+            buf.write_array<endianness>(std::span<const T>(values));
+            buf.read_single();
+            buf.read_array<endianness>(std::span<T>(compare));
+            bench_keep(compare[0]);
+        }
+    });
+    std::snprintf(name, sizeof name, "write_array/read_array %s", type_name);
+    bench_report(name, samples * rounds, seconds);
+}
+
+int main(void)
+{
+#if defined(__AVX2__)
+    std::printf("byte-swapping with AVX2\n");
+#elif defined(__SSSE3__)
+    std::printf("byte-swapping with SSSE3\n");
+#elif defined(__ARM_NEON)
+    std::printf("byte-swapping with NEON\n");
+#else
+    std::printf("byte-swapping with scalar code\n");
+#endif
+
+    run<uint16_t>("uint16_t");
+    run<uint32_t>("uint32_t");
+    run<float>("float");
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+/* toolchain */
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+/* internal */
+#include "bench.h"
+#include "buffer/PcBuffer.h"
+
+using namespace Coral;
+
+static constexpr uint64_t lines = 2000000;
+
+using Buffer = PcBuffer<4096, char>;
+
+static const char line[] = "set channel 12 frequency 433.92 power 10\n";
+static constexpr std::size_t line_length = sizeof(line) - 1;
+
+/* Find line boundaries by popping one element at a time. */
+static std::size_t frame_single(Buffer &buf, std::array<char, 128> &out)
+{
+    std::size_t index = 0;
+    while (ToBool(buf.pop(out[index])) and out[index] != '\n')
+    {
+        index++;
+    }
+    return index;
+}
+
+/* Pop a line at a time. */
+static std::size_t frame_until(Buffer &buf, std::array<char, 128> &out)
+{
+    return buf.pop_until('\n', out.data(), out.size());
+}
+
+template <typename Frame> void run(const char *name, Frame frame)
+{
+    Buffer buf;
+    std::array<char, 128> out;
+
+    double seconds = bench_seconds([&]() {
+        std::size_t total = 0;
+        for (uint64_t i = 0; i < lines; i++)
+        {
+            buf.push_n(line, line_length);
+            total += frame(buf, out);
+        }
+        bench_keep(total);
+    });
+
+    bench_report(name, lines, seconds);
+}
+
+int main(void)
+{
+    run("lines, pop per element", frame_single);
+    run("lines, pop_until", frame_until);
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+/* toolchain */
+#include <array>
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* internal */
+#include "bench.h"
+#include "buffer/MessageBuffer.h"
+#include "io/iovec.h"
+
+using namespace Coral;
+
+static constexpr uint64_t messages = 1000000;
+static constexpr std::size_t batch = 16;
+static constexpr std::size_t message_size = 48;
+
+using Buffer = InlineMessageBuffer<4096, char>;
+
+/* Queue a batch of messages, then send them to fd. */
+template <typename Drain> void run(const char *name, int fd, Drain drain)
+{
+    Buffer buf;
+    std::array<char, message_size> message;
+    message.fill('m');
+
+    double seconds = bench_seconds([&]() {
+        for (uint64_t i = 0; i < messages; i += batch)
+        {
+            for (std::size_t j = 0; j < batch; j++)
+            {
+                buf.put_message(message.data(), message.size());
+            }
+            drain(buf, fd);
+        }
+    });
+
+    bench_report(name, messages, seconds);
+}
+
+/* A copy and a write per message. */
+static void drain_single(Buffer &buf, int fd)
+{
+    std::array<char, message_size> out;
+    std::size_t len;
+    while (ToBool(buf.get_message(out.data(), len)))
+    {
+        bench_keep(write(fd, out.data(), len));
+    }
+}
+
+/* Every queued message in place, with one writev. */
+static void drain_batch(Buffer &buf, int fd)
+{
+    std::array<RingSegments<const char>, batch> views;
+    std::array<struct iovec, batch * 2> iovecs;
+    std::size_t regions;
+
+    std::size_t count = buf.get_messages(views);
+    std::size_t used = gather_iovecs(views.data(), count, iovecs, regions);
+    bench_keep(writev(fd, iovecs.data(), used));
+    buf.release(regions);
+}
+
+int main(void)
+{
+    int fd = open("/dev/null", O_WRONLY);
+    assert(fd >= 0);
+
+    run("drain, get_message + write", fd, drain_single);
+    run("drain, get_messages + writev", fd, drain_batch);
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* toolchain */
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* internal */
+#include "bench.h"
+#include "buffer/MpmcBuffer.h"
+#include "buffer/PcBuffer.h"
+
+using namespace Coral;
+
+struct Record
+{
+    uint64_t producer;
+    uint64_t sequence;
+};
+
+static constexpr std::size_t depth = 1024;
+static constexpr uint64_t per_producer = 200000;
+
+/* The only way to share a PcBuffer today: one lock for the whole process. */
+static std::mutex global_mutex;
+
+class GlobalMutexLock : public ContextLock<GlobalMutexLock>
+{
+  public:
+    inline void lock(void)
+    {
+        global_mutex.lock();
+    }
+
+    inline void unlock(void)
+    {
+        global_mutex.unlock();
+    }
+};
+
+template <class Buffer> double run(std::size_t producers)
+{
+    Buffer buf;
+
+    return bench_seconds([&]() {
+        std::vector<std::thread> threads;
+        for (std::size_t id = 0; id < producers; id++)
+        {
+            threads.emplace_back([&buf, id]() {
+                for (uint64_t i = 0; i < per_producer; i++)
+                {
+                    while (not ToBool(buf.push({id, i})))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        /* Single drain thread. */
+        std::array<Record, 64> records;
+        uint64_t remaining = per_producer * producers;
+        while (remaining)
+        {
+            std::size_t count = buf.try_pop_n(records);
+            remaining -= count;
+            bench_keep(records);
+            if (not count)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    });
+}
+
+int main(void)
+{
+    std::size_t max_producers =
+        std::clamp<std::size_t>(std::thread::hardware_concurrency(), 2, 8);
+
+    for (std::size_t producers = 1; producers <= max_producers; producers++)
+    {
+        char name[64];
+        uint64_t ops = per_producer * producers;
+
+        std::snprintf(name, sizeof name, "MpmcBuffer producers=%zu",
+                      producers);
+        bench_report(name, ops, run<MpmcBuffer<depth, Record>>(producers));
+
+        std::snprintf(name, sizeof name, "PcBuffer+mutex producers=%zu",
+                      producers);
+        bench_report(
+            name, ops,
+            run<PcBuffer<depth, Record, alignof(Record), GlobalMutexLock>>(
+                producers));
+    }
+
+    return 0;
+}
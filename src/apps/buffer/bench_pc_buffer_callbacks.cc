@@ -0,0 +1,103 @@
+/* toolchain */
+#include <cstdio>
+
+/* internal */
+#include "bench.h"
+#include "buffer/PcBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t depth = 1024;
+static constexpr uint64_t elements = 20000000;
+
+/* Counts service invocations through hooks bound at compile time. */
+class HookBuffer : public PcBufferBase<HookBuffer, depth, uint8_t>
+{
+  public:
+    inline void service_data_impl(void)
+    {
+        data_calls++;
+    }
+
+    inline void service_space_impl(void)
+    {
+        space_calls++;
+    }
+
+    uint64_t data_calls = 0;
+    uint64_t space_calls = 0;
+};
+
+/* A lock that does nothing but opts in to parking (and so notifying). */
+class ParkingNoopLock
+{
+  public:
+    static constexpr bool parks = true;
+
+    inline void lock(void)
+    {
+        ;
+    }
+
+    inline void unlock(void)
+    {
+        ;
+    }
+};
+
+/* Push a byte at a time, draining the buffer a byte at a time when full. */
+template <class Buffer> void run(Buffer &buf)
+{
+    uint8_t elem;
+    for (uint64_t i = 0; i < elements; i++)
+    {
+        if (not ToBool(buf.push(static_cast<uint8_t>(i))))
+        {
+            while (ToBool(buf.pop(elem)))
+            {
+                bench_keep(elem);
+            }
+            buf.push(static_cast<uint8_t>(i));
+        }
+    }
+    buf.pop_all();
+}
+
+int main(void)
+{
+    {
+        PcBuffer<depth, uint8_t> buf;
+        bench_report("PcBuffer (no callbacks)", elements,
+                     bench_seconds([&buf]() { run(buf); }));
+    }
+
+    {
+        PcBuffer<depth, uint8_t, 1, ParkingNoopLock> buf;
+        bench_report("PcBuffer (parking, no callbacks)", elements,
+                     bench_seconds([&buf]() { run(buf); }));
+    }
+
+    {
+        uint64_t data_calls = 0;
+        uint64_t space_calls = 0;
+        using Buffer = PcBuffer<depth, uint8_t>;
+
+        Buffer buf(
+            false, [&space_calls](Buffer *) { space_calls++; },
+            [&data_calls](Buffer *) { data_calls++; });
+        bench_report("PcBuffer (std::function)", elements,
+                     bench_seconds([&buf]() { run(buf); }));
+        bench_keep(data_calls);
+        bench_keep(space_calls);
+    }
+
+    {
+        HookBuffer buf;
+        bench_report("PcBufferBase (CRTP hooks)", elements,
+                     bench_seconds([&buf]() { run(buf); }));
+        bench_keep(buf.data_calls);
+        bench_keep(buf.space_calls);
+    }
+
+    return 0;
+}
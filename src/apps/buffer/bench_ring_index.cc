@@ -0,0 +1,58 @@
+/* toolchain */
+#include <cstdio>
+
+/* internal */
+#include "bench.h"
+#include "buffer/CircularBuffer.h"
+
+using namespace Coral;
+
+static constexpr uint64_t elements = 50000000;
+static constexpr std::size_t chunk = 37;
+
+/* Stream elements through the buffer one at a time. */
+template <std::size_t depth> void run_single(const char *name)
+{
+    CircularBuffer<depth, uint32_t> buf;
+
+    double seconds = bench_seconds([&buf]() {
+        uint32_t sum = 0;
+        for (uint64_t i = 0; i < elements; i++)
+        {
+            buf.write_single(static_cast<uint32_t>(i));
+            sum += buf.read_single();
+        }
+        bench_keep(sum);
+    });
+
+    bench_report(name, elements, seconds);
+}
+
+/* Stream elements through the buffer in odd-sized chunks. */
+template <std::size_t depth> void run_chunks(const char *name)
+{
+    CircularBuffer<depth, uint32_t> buf;
+    std::array<uint32_t, chunk> data = {};
+
+    double seconds = bench_seconds([&]() {
+        for (uint64_t i = 0; i < elements / chunk; i++)
+        {
+            data[0] = static_cast<uint32_t>(i);
+            buf.write_n(data.data(), chunk);
+            buf.read_n(data.data(), chunk);
+            bench_keep(data[0]);
+        }
+    });
+
+    bench_report(name, elements / chunk * chunk, seconds);
+}
+
+int main(void)
+{
+    run_single<1024>("single, depth=1024 (mask)");
+    run_single<1000>("single, depth=1000 (branch)");
+    run_chunks<1024>("chunks, depth=1024 (mask)");
+    run_chunks<1000>("chunks, depth=1000 (branch)");
+
+    return 0;
+}
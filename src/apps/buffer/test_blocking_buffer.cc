@@ -0,0 +1,127 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+/* internal */
+#include "Locks.h"
+#include "buffer/MpmcBuffer.h"
+#include "buffer/PcBuffer.h"
+#include "buffer/SpscBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t depth = 16;
+static constexpr uint32_t count = 5000;
+
+template <class Buffer> void test_timeout(void)
+{
+    using clock = std::chrono::steady_clock;
+    static constexpr auto timeout = std::chrono::milliseconds(5);
+
+    Buffer buf;
+
+    auto start = clock::now();
+    assert(not buf.wait_for_data(1, timeout));
+    assert(clock::now() - start >= timeout);
+    assert(buf.wait_for_space(depth, timeout));
+
+    assert(buf.push(1u));
+    assert(buf.wait_for_data(1, timeout));
+    assert(not buf.wait_for_data(2, std::chrono::nanoseconds(0)));
+
+    for (uint32_t i = 1; i < depth; i++)
+    {
+        assert(buf.push(i));
+    }
+    start = clock::now();
+    assert(not buf.wait_for_space(1, timeout));
+    assert(clock::now() - start >= timeout);
+}
+
+template <class Buffer> void test_threads(void)
+{
+    Buffer buf;
+
+    /* Consumer parks until data arrives. */
+    std::thread consumer([&buf]() {
+        uint32_t val;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            buf.pop_blocking(val);
+            assert(val == i);
+        }
+
+        std::array<uint32_t, depth * 2> vals;
+        buf.pop_n_blocking(vals.data(), vals.size());
+        for (uint32_t i = 0; i < vals.size(); i++)
+        {
+            assert(vals[i] == i);
+        }
+    });
+
+    /* Producer parks until space is available. */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        buf.push_blocking(i);
+    }
+
+    std::array<uint32_t, depth * 2> vals;
+    for (uint32_t i = 0; i < vals.size(); i++)
+    {
+        vals[i] = i;
+    }
+    buf.push_n_blocking(vals.data(), vals.size());
+
+    consumer.join();
+    assert(buf.empty());
+}
+
+void test_flush(void)
+{
+    PcBuffer<depth, uint32_t, sizeof(uint32_t), MutexLock<>> buf;
+
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        assert(buf.push(i));
+    }
+
+    std::thread consumer([&buf]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        assert(buf.pop_all() == depth);
+    });
+
+    /* Parks (rather than asserting on a missing callback) until drained. */
+    buf.flush();
+    assert(buf.empty());
+
+    consumer.join();
+}
+
+int main(void)
+{
+    using Spsc = SpscBuffer<depth, uint32_t>;
+    using Mpmc = MpmcBuffer<depth, uint32_t>;
+    using Pc = PcBuffer<depth, uint32_t, sizeof(uint32_t), MutexLock<>>;
+
+    test_timeout<Spsc>();
+    test_timeout<Mpmc>();
+    test_timeout<Pc>();
+
+    /* Single-threaded buffers poll rather than park. */
+    using Polling = PcBuffer<depth, uint32_t>;
+    static_assert(sizeof(Polling) < sizeof(Pc));
+    test_timeout<Polling>();
+
+    test_threads<Spsc>();
+    test_threads<Mpmc>();
+    test_threads<Pc>();
+
+    test_flush();
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+/* internal */
+#include "buffer/BroadcastBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t depth = 16;
+
+using Buffer = BroadcastBuffer<depth, uint32_t, 3>;
+using DropBuffer =
+    BroadcastBuffer<depth, uint32_t, 3, sizeof(uint32_t), ArrayStorage, true>;
+
+void test_basic(void)
+{
+    Buffer buf;
+    std::array<uint32_t, depth> vals;
+    uint32_t val;
+
+    /* With no readers, writes are simply discarded. */
+    for (uint32_t i = 0; i < depth * 2 + 3; i++)
+    {
+        assert(buf.push(i));
+    }
+
+    auto *first = buf.attach();
+    auto *second = buf.attach();
+    auto *third = buf.attach();
+    assert(first and second and third);
+    assert(not buf.attach());
+
+    /* Readers are admitted at the writer's next write. */
+    assert(first->empty());
+    assert(not first->pop(val));
+    assert(buf.push(100u));
+    assert(first->pop(val));
+    assert(val == 100);
+    assert(second->pop(val));
+    assert(val == 100);
+
+    /* Space is reclaimed at the slowest reader. */
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        vals[i] = i;
+    }
+    assert(third->data_available() == 1);
+    assert(buf.try_push_n(vals.data(), depth) == depth - 1);
+    assert(not buf.push(0u, true));
+    assert(buf.write_dropped() == 1);
+
+    assert(first->pop_all() == depth - 1);
+    assert(second->try_pop_n(vals.data(), depth) == depth - 1);
+    assert(vals[0] == 0 and vals[depth - 2] == depth - 2);
+    assert(buf.space_available() == 0);
+
+    /* A reader that leaves no longer holds the writer back. */
+    third->detach();
+    assert(buf.space_available() == depth);
+    assert(buf.push(vals));
+
+    /* Zero-copy access across the wrap point. */
+    auto region = first->peek_read();
+    assert(region.size() == depth);
+    assert(not region.contiguous());
+    assert(region.first[0] == 0);
+    assert(first->consume(depth));
+    assert(not first->consume(1));
+
+    vals.fill(0);
+    assert(second->pop(vals));
+    assert(vals[depth - 1] == depth - 1);
+
+    /* The freed slot can be reused. */
+    third = buf.attach();
+    assert(third);
+    auto segments = buf.reserve_write(2);
+    assert(segments.contiguous());
+    segments.first[0] = 7;
+    segments.first[1] = 8;
+    assert(buf.commit_write(2));
+    for (auto *reader : {first, second, third})
+    {
+        assert(reader->pop(val));
+        assert(val == 7);
+        assert(reader->pop(val));
+        assert(val == 8);
+        assert(reader->empty());
+    }
+}
+
+void test_drop_lagging(void)
+{
+    DropBuffer buf;
+    std::array<uint32_t, depth> vals = {};
+    uint32_t val;
+
+    auto *fast = buf.attach();
+    auto *slow = buf.attach();
+
+    /* The writer never waits on a reader that falls behind. */
+    for (uint32_t i = 0; i < depth * 4; i++)
+    {
+        assert(buf.push(i));
+        assert(fast->pop(val));
+        assert(val == i);
+    }
+    assert(slow->lagged());
+    assert(buf.readers_dropped() == 1);
+    assert(not slow->pop(val));
+
+    /* Resynchronizing skips to the next write. */
+    assert(slow->resync());
+    assert(not slow->resync());
+    assert(not slow->pop(val));
+    assert(buf.push(1000u));
+    assert(slow->pop(val));
+    assert(val == 1000);
+    assert(fast->pop(val));
+    assert(val == 1000);
+
+    /* Caught-up readers aren't dropped. */
+    assert(buf.push(vals));
+    assert(fast->pop(vals));
+    assert(slow->pop(vals));
+    assert(buf.push(vals));
+    assert(buf.readers_dropped() == 1);
+}
+
+void test_threads(void)
+{
+    static constexpr uint32_t count = 100000;
+
+    Buffer buf;
+    std::vector<std::thread> threads;
+    std::array<Buffer::Reader *, 3> readers;
+
+    for (auto &reader : readers)
+    {
+        reader = buf.attach();
+    }
+
+    for (auto *reader : readers)
+    {
+        threads.emplace_back([reader]() {
+            std::array<uint32_t, 7> chunk;
+            uint32_t expected = 0;
+            while (expected < count)
+            {
+                std::size_t n = std::min<std::size_t>(chunk.size(),
+                                                      count - expected);
+                reader->pop_n_blocking(chunk.data(), n);
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    assert(chunk[i] == expected++);
+                }
+            }
+        });
+    }
+
+    std::array<uint32_t, 5> chunk;
+    for (uint32_t i = 0; i < count; i += chunk.size())
+    {
+        for (std::size_t j = 0; j < chunk.size(); j++)
+        {
+            chunk[j] = i + j;
+        }
+        buf.push_n_blocking(chunk.data(), chunk.size());
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void test_threads_lagging(void)
+{
+    static constexpr uint32_t count = 100000;
+
+    DropBuffer buf;
+    auto *reader = buf.attach();
+    std::atomic<bool> done = false;
+
+    /* Whatever a lagging reader sees is still in order. */
+    std::thread thread([reader, &done]() {
+        uint32_t val;
+        uint32_t last = 0;
+        do
+        {
+            reader->pop_blocking(val);
+            assert(val == 0 or val > last);
+            last = val;
+        } while (val < count);
+        done = true;
+    });
+
+    /* Keep writing until the reader sees the end (it may skip past it). */
+    for (uint32_t i = 0; not done; i++)
+    {
+        buf.push_blocking(i);
+    }
+
+    thread.join();
+}
+
+int main(void)
+{
+    test_basic();
+    test_drop_lagging();
+    test_threads();
+    test_threads_lagging();
+    return 0;
+}
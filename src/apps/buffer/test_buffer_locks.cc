@@ -0,0 +1,127 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <cassert>
+#include <thread>
+#include <vector>
+
+/* internal */
+#include "Locks.h"
+#include "buffer/MessageBuffer.h"
+#include "buffer/PcBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t depth = 64;
+static constexpr std::size_t threads = 4;
+static constexpr uint32_t per_thread = 2000;
+
+/* Context locks don't occupy space in a buffer. */
+static_assert(sizeof(PcBuffer<depth, uint8_t>) <
+              sizeof(PcBuffer<depth, uint8_t, 1, SpinLock<true>>));
+
+template <class Lock> void test_lock_policy(bool metrics = true)
+{
+    using Buffer = PcBuffer<depth, uint32_t, sizeof(uint32_t), Lock>;
+
+    /* Independent buffers have independent locks. */
+    Buffer buf;
+    Buffer other;
+    assert(&buf.lock.get() != &other.lock.get());
+
+    std::vector<std::thread> producers;
+    for (std::size_t i = 0; i < threads; i++)
+    {
+        producers.emplace_back([&buf]() {
+            for (uint32_t j = 0; j < per_thread; j++)
+            {
+                while (not buf.push(j))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    std::array<uint32_t, 16> data;
+    while (count < threads * per_thread)
+    {
+        std::size_t popped = buf.try_pop_n(data);
+        for (std::size_t i = 0; i < popped; i++)
+        {
+            sum += data[i];
+        }
+        count += popped;
+    }
+
+    for (auto &thread : producers)
+    {
+        thread.join();
+    }
+
+    assert(buf.empty());
+    assert(sum == threads * (uint64_t(per_thread) * (per_thread - 1) / 2));
+
+    /* Every critical section was counted. */
+    auto &policy = buf.lock.get();
+    if (metrics)
+    {
+        assert(policy.acquisitions() >= threads * per_thread);
+    }
+    assert(policy.contended() <= policy.acquisitions());
+    assert(other.lock.get().acquisitions() == 0);
+}
+
+void test_message_buffer(void)
+{
+    MessageBuffer<depth, 4, char, 1, MutexLock<true>> msg_buf;
+    std::array<char, depth> buf = {};
+    std::size_t len = 0;
+
+    assert(msg_buf.put_message("hello", 6));
+    assert(msg_buf.lock.get().acquisitions() == 1);
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 6);
+
+    /* A context holds the lock for its lifetime. */
+    {
+        auto ctx = msg_buf.context();
+        assert(not msg_buf.lock.get().try_lock());
+        ctx.log("%s", "hi");
+    }
+    assert(msg_buf.lock.get().try_lock());
+    msg_buf.lock.get().unlock();
+
+    /* Overflowing a context rejects its message (without deadlocking). */
+    {
+        auto ctx = msg_buf.context();
+        msg_buf.write_n(buf.data(), buf.size());
+        msg_buf.write_n(buf.data(), buf.size());
+    }
+    assert(msg_buf.rejected() == 1);
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 2);
+    assert(msg_buf.empty());
+}
+
+int main(void)
+{
+    test_lock_policy<SpinLock<true>>();
+    test_lock_policy<TicketLock<true>>();
+    test_lock_policy<MutexLock<true>>();
+    test_lock_policy<TicketLock<>>(false);
+    test_message_buffer();
+
+    /* Metrics are optional. */
+    SpinLock<> lock;
+    assert(lock.try_lock());
+    assert(not lock.try_lock());
+    lock.unlock();
+    assert(lock.acquisitions() == 0);
+
+    return 0;
+}
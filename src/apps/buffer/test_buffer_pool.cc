@@ -0,0 +1,184 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+/* internal */
+#include "buffer/BufferPool.h"
+#include "buffer/MessageBuffer.h"
+#include "buffer/PcBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t slab_count = 32;
+
+void test_slabs(void)
+{
+    BufferPool pool(100, slab_count);
+
+    /* Sizes round up to whole cache lines. */
+    assert(pool.slab_size() == 128);
+    assert(pool.slab_count() == slab_count);
+
+    std::array<void *, slab_count> slabs;
+    for (auto &slab : slabs)
+    {
+        slab = pool.acquire();
+        assert(slab);
+        assert(pool.owns(slab));
+        assert(reinterpret_cast<std::uintptr_t>(slab) % cache_line_size ==
+               0);
+        std::memset(slab, 0xaa, pool.slab_size());
+    }
+    assert(pool.acquire() == nullptr);
+
+    BufferPoolStats stats = pool.stats();
+    assert(stats.in_use == slab_count);
+    assert(stats.high_watermark == slab_count);
+    assert(stats.exhausted == 1);
+
+    /* Released slabs come back from this thread's cache first. */
+    pool.release(slabs[3]);
+    assert(pool.acquire() == slabs[3]);
+    assert(pool.stats().cache_hits == 1);
+
+    for (auto slab : slabs)
+    {
+        pool.release(slab);
+    }
+
+    /* Every slab is usable again, whether cached or shared. */
+    for (auto &slab : slabs)
+    {
+        slab = pool.acquire();
+        assert(slab);
+    }
+    assert(pool.acquire() == nullptr);
+    for (auto slab : slabs)
+    {
+        pool.release(slab);
+    }
+
+    stats = pool.stats();
+    assert(stats.in_use == 0);
+    assert(stats.acquires == stats.releases);
+    assert(stats.high_watermark == slab_count);
+}
+
+void test_objects(void)
+{
+    using Buffer = PcBuffer<64, uint32_t>;
+    using Messages = MessageBuffer<256, 4, char>;
+
+    BufferPool pool(std::max(sizeof(Buffer), sizeof(Messages)), 4);
+
+    auto buf = pool.make<Buffer>();
+    assert(buf);
+    uint32_t val = 0;
+    assert(buf->push(7u));
+    assert(buf->pop(val));
+    assert(val == 7);
+
+    auto messages = pool.make<Messages>();
+    assert(messages);
+    assert(messages->empty());
+    assert(pool.stats().in_use == 2);
+
+    buf.reset();
+    messages.reset();
+    assert(pool.stats().in_use == 0);
+
+    /* Handles are empty once the pool is exhausted. */
+    std::vector<BufferPool::Handle<Buffer>> handles;
+    for (std::size_t i = 0; i < pool.slab_count(); i++)
+    {
+        handles.push_back(pool.make<Buffer>());
+        assert(handles.back());
+    }
+    assert(not pool.make<Buffer>());
+    handles.clear();
+
+    /* So are handles to objects that don't fit a slab. */
+    BufferPool small(cache_line_size, 2);
+    assert(small.slab_size() < sizeof(Buffer));
+    assert(not small.make<Buffer>());
+    assert(small.stats().acquires == 0);
+}
+
+void test_resource(void)
+{
+    BufferPool pool(64 * sizeof(uint32_t), 2);
+
+    {
+        DynamicPcBuffer<uint32_t> buf(64, &pool);
+        assert(buf.push(1u));
+        assert(pool.stats().in_use == 1);
+
+        /* Too big for a slab, so served upstream. */
+        DynamicPcBuffer<uint32_t> big(128, &pool);
+        assert(big.push(2u));
+        assert(pool.stats().overflow == 1);
+        assert(pool.stats().in_use == 1);
+    }
+
+    assert(pool.stats().in_use == 0);
+}
+
+void test_threads(void)
+{
+    static constexpr std::size_t iterations = 2000;
+    static constexpr std::size_t thread_count = 4;
+    static constexpr std::size_t held = slab_count / thread_count / 2;
+
+    BufferPool pool(64, slab_count);
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&pool, t]() {
+            std::array<uint8_t *, held> slabs;
+            for (std::size_t i = 0; i < iterations; i++)
+            {
+                for (auto &slab : slabs)
+                {
+                    slab = static_cast<uint8_t *>(pool.acquire());
+                    assert(slab);
+                    *slab = static_cast<uint8_t>(t);
+                }
+                std::this_thread::yield();
+                for (auto slab : slabs)
+                {
+                    /* No one else was handed this slab. */
+                    assert(*slab == t);
+                    pool.release(slab);
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    BufferPoolStats stats = pool.stats();
+    assert(stats.in_use == 0);
+    assert(stats.exhausted == 0);
+    assert(stats.acquires == iterations * thread_count * held);
+    assert(stats.high_watermark <= slab_count);
+}
+
+int main(void)
+{
+    test_slabs();
+    test_objects();
+    test_resource();
+    test_threads();
+    return 0;
+}
@@ -0,0 +1,179 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <memory_resource>
+#include <thread>
+
+/* internal */
+#include "Locks.h"
+#include "buffer/PcBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t capacity = 10;
+
+template <class Buffer> void test_basic(Buffer &buf)
+{
+    assert(buf.capacity() == capacity);
+    assert(buf.empty());
+
+    /* Wrap around a few times (capacity isn't a power of two). */
+    for (uint32_t i = 0; i < capacity * 3; i++)
+    {
+        assert(buf.push(i));
+        assert(buf.push(i + 1));
+        uint32_t val;
+        assert(buf.pop(val));
+        assert(val == i);
+        assert(buf.pop(val));
+        assert(val == i + 1);
+    }
+
+    /* Fill, overflow, then drain. */
+    std::array<uint32_t, capacity> vals;
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        vals[i] = i;
+    }
+    assert(buf.push_n(vals.data(), capacity));
+    assert(buf.full());
+    assert(not buf.push(0u, true));
+
+    vals.fill(0);
+    assert(buf.pop_all(vals.data()) == capacity);
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        assert(vals[i] == i);
+    }
+
+    /* Partial transfers. */
+    assert(buf.try_push_n(vals.data(), capacity + 5) == capacity);
+    assert(buf.try_pop_n(vals.data(), 4) == 4);
+
+    /* Zero-copy access straddling the wrap point. */
+    auto seg = buf.reserve_write();
+    assert(seg.size() == 4);
+    assert(seg.first.size() == 4);
+    for (auto &elem : seg.first)
+    {
+        elem = 100;
+    }
+    assert(buf.commit_write(4));
+
+    auto read = buf.peek_read();
+    assert(read.size() == capacity);
+    assert(read.first.size() == capacity - 4);
+    assert(read.second.size() == 4);
+    assert(read.second[0] == 100);
+    assert(buf.consume(capacity));
+    assert(buf.empty());
+
+    BufferMetrics metrics = buf.metrics();
+    assert(metrics.capacity == capacity);
+    assert(metrics.element_size == sizeof(uint32_t));
+    assert(metrics.dropped_full == 1);
+}
+
+void test_span(void)
+{
+    std::array<uint32_t, capacity> storage;
+    DynamicPcBuffer<uint32_t> buf(storage);
+
+    test_basic(buf);
+
+    /* Elements land in the caller's storage. */
+    assert(buf.push(0xabcdu));
+    assert(std::ranges::find(storage, 0xabcdu) != storage.end());
+}
+
+void test_resource(void)
+{
+    std::array<std::byte, 256> arena;
+    std::pmr::monotonic_buffer_resource resource(
+        arena.data(), arena.size(), std::pmr::null_memory_resource());
+
+    DynamicPcBuffer<uint32_t> buf(capacity, &resource);
+    test_basic(buf);
+
+    /* Default resource (the heap). */
+    DynamicPcBuffer<uint32_t> heap(capacity);
+    test_basic(heap);
+}
+
+void test_callbacks(void)
+{
+    std::array<char, 8> storage;
+    std::size_t serviced = 0;
+
+    DynamicPcBuffer<char> buf(
+        storage, true, nullptr, [&serviced](DynamicPcBuffer<char> *self) {
+            serviced += self->pop_all();
+        });
+
+    for (char i = 0; i < 20; i++)
+    {
+        buf.push_blocking(i);
+    }
+    buf.flush();
+    assert(serviced == 20);
+}
+
+void test_threads(void)
+{
+    static constexpr uint32_t count = 2000;
+
+    DynamicPcBuffer<uint32_t, SpinLock<>> buf(7);
+
+    std::thread consumer([&buf]() {
+        uint32_t val;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            buf.pop_blocking(val);
+            assert(val == i);
+        }
+    });
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        buf.push_blocking(i);
+    }
+
+    consumer.join();
+    assert(buf.empty());
+}
+
+void test_struct(void)
+{
+    DynamicPcBuffer<uint8_t> buf(BufferState::size + 4);
+
+    BufferState state = {};
+    state.write_cursor = 1;
+    state.read_count = 0x01020304;
+    BufferState out = {};
+
+    /* The ring isn't a multiple of the struct size, so most wrap. */
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        state.read_cursor = i;
+        assert(buf.push_struct<std::endian::big>(state));
+        assert(not buf.push_struct<std::endian::big>(state, true));
+        assert(buf.pop_struct<std::endian::big>(out));
+        assert(out == state);
+    }
+    assert(buf.empty());
+}
+
+int main(void)
+{
+    test_span();
+    test_resource();
+    test_callbacks();
+    test_struct();
+    test_threads();
+    return 0;
+}
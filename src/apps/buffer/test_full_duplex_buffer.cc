@@ -2,9 +2,100 @@
 #undef NDEBUG
 #endif
 
+/* toolchain */
+#include <cassert>
+#include <string>
+
 /* internal */
 #include "SampleFdBuffer.h"
 
+/* A link that takes up to a budget of elements per dispatch. */
+class LaneFdBuffer
+    : public FullDuplexBuffer<LaneFdBuffer, 64, 64, char, 1, 3>
+{
+  public:
+    LaneFdBuffer() : FullDuplexBuffer(false), budget(0), wire()
+    {
+    }
+
+    inline std::size_t transmit_impl(std::span<const char> data)
+    {
+        std::size_t count = std::min(budget, data.size());
+        wire.append(data.data(), count);
+        budget -= count;
+        return count;
+    }
+
+    inline void service_rx_impl(RxBuffer *buf)
+    {
+        (void)buf;
+    }
+
+    /* Let the link take some more data. */
+    inline std::string send(std::size_t count)
+    {
+        budget = count;
+        wire.clear();
+        dispatch();
+        budget = 0;
+        return wire;
+    }
+
+    std::size_t budget;
+    std::string wire;
+};
+
+void test_strict_priority(void)
+{
+    LaneFdBuffer link;
+
+    /* Bulk data queues on the default (lowest-priority) lane. */
+    assert(link.tx.push_n("bbbbbbbbbbbb", 12));
+    assert(link.send(4) == "bbbb");
+
+    /* Control data skips the queue, whichever order it arrives in. */
+    assert(link.lane(1).push_n("mm", 2));
+    assert(link.lane(0).push_n("cc", 2));
+    assert(link.send(3) == "ccm");
+    assert(link.lane(0).push('c'));
+    assert(link.send(4) == "cmbb");
+    assert(link.send(100) == "bbbbbb");
+    assert(link.send(100).empty());
+
+    /* Pushes try the link too (finding it full, here). */
+    TxLaneStats stats = link.lane_stats(2);
+    assert(stats.sent == 12);
+    assert(stats.bursts == 3);
+    assert(stats.buffer.write_total == 12);
+    assert(stats.waited == 7);
+    assert(link.lane_stats(0).sent == 3);
+    assert(link.lane_stats(1).waited == 4);
+}
+
+void test_weighted_fair(void)
+{
+    LaneFdBuffer link;
+    link.set_tx_policy(TxPolicy::weighted_fair);
+    link.set_quantum(0, 2);
+    link.set_quantum(1, 1);
+    link.set_quantum(2, 1);
+
+    assert(link.lane(0).push_n("aaaaaa", 6));
+    assert(link.lane(1).push_n("bbbbbb", 6));
+    assert(link.tx.push_n("cccccc", 6));
+
+    /* Turns resume where the link filled up. */
+    assert(link.send(3) == "aab");
+    assert(link.send(3) == "caa");
+    assert(link.send(5) == "bcaab");
+
+    /* Idle lanes don't bank credit. */
+    assert(link.send(100) == "cbcbcbc");
+    assert(link.lane(0).push_n("aaaa", 4));
+    assert(link.tx.push_n("cccc", 4));
+    assert(link.send(100) == "aacaaccc");
+}
+
 int main(void)
 {
     SampleFdBuffer buffer;
@@ -16,5 +107,8 @@ int main(void)
     std::stringstream("Hello, world! (rx)\n") >> buffer.rx;
     std::cout << buffer.rx;
 
+    test_strict_priority();
+    test_weighted_fair();
+
     return 0;
 }
@@ -4,10 +4,14 @@
 
 /* internal */
 #include "buffer/MessageBuffer.h"
+#include "io/iovec.h"
 
 /* toolchain */
+#include <unistd.h>
+
 #include <iostream>
 #include <stdfloat>
+#include <string>
 
 static constexpr std::size_t buffer_size = 256;
 
@@ -54,6 +58,454 @@ void struct_test(CircBuffer &circ_buf)
     assert(state2.write_count == 4);
 }
 
+template <typename T, std::endian endianness = std::endian::native>
+void array_test(CircBuffer &circ_buf)
+{
+    static constexpr std::size_t count = 29;
+
+    std::array<T, count> values;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        values[i] = static_cast<T>(i * 0x01020304 + 0x11);
+    }
+
+    /* Shift the cursors by a byte at a time so values straddle the end. */
+    for (std::size_t shift = 0; shift < sizeof(T) * 2; shift++)
+    {
+        circ_buf.write_single(std::byte{'x'});
+        circ_buf.read_single();
+
+        /* Bulk write matches per-element reads. */
+        assert(circ_buf.write_array<endianness>(std::span<const T>(values)) ==
+               sizeof(values));
+        for (std::size_t i = 0; i < count; i++)
+        {
+            assert((circ_buf.read<endianness, T>() == values[i]));
+        }
+
+        /* Per-element writes match a bulk read. */
+        for (std::size_t i = 0; i < count; i++)
+        {
+            circ_buf.write<endianness, T>(values[i]);
+        }
+        std::array<T, count> compare = {};
+        assert(circ_buf.read_array<endianness>(std::span<T>(compare)) ==
+               sizeof(compare));
+        assert(compare == values);
+    }
+}
+
+void overwrite_test(void)
+{
+    Coral::MessageBuffer<16, 4, char> msg_buf;
+    msg_buf.set_overwrite();
+
+    std::array<char, 16> buf = {};
+    std::size_t len = 0;
+
+    /* The fifth message evicts the first (message count limit). */
+    for (char i = 0; i < 5; i++)
+    {
+        buf.fill(i);
+        assert(msg_buf.put_message(buf.data(), 2));
+    }
+    assert(msg_buf.evicted() == 1);
+
+    /* A large message evicts as many whole messages as it needs. */
+    buf.fill(5);
+    assert(msg_buf.put_message(buf.data(), 12));
+    assert(msg_buf.evicted() == 3);
+    for (char i = 3; i < 5; i++)
+    {
+        assert(msg_buf.get_message(buf.data(), len));
+        assert(len == 2 and buf[0] == i);
+    }
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 12 and buf[0] == 5);
+    assert(msg_buf.empty());
+
+    /* Oversized messages are still rejected. */
+    assert(not msg_buf.put_message(buf.data(), 17));
+
+    /* Contexts may overwrite the oldest messages as they write. */
+    buf.fill(6);
+    assert(msg_buf.put_message(buf.data(), 10));
+    {
+        auto ctx = msg_buf.context();
+        assert(ctx.max == 16);
+        msg_buf.write_n("abcdefgh", 8);
+    }
+    assert(msg_buf.evicted() == 4);
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 8 and std::string(buf.data(), len) == "abcdefgh");
+    assert(msg_buf.empty());
+}
+
+void inline_test(void)
+{
+    Coral::InlineMessageBuffer<64, char> msg_buf;
+    static_assert(msg_buf.max_header == 1);
+
+    std::array<char, 64> buf = {};
+    std::size_t len = 0;
+
+    /* Small messages are only limited by their size (plus a byte each). */
+    std::size_t count = 0;
+    while (ToBool(msg_buf.put_message("abc", 3)))
+    {
+        count++;
+    }
+    assert(count == 16);
+    assert(msg_buf.full(1));
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        assert(msg_buf.get_message(buf.data(), len));
+        assert(len == 3 and std::string(buf.data(), len) == "abc");
+    }
+    assert(msg_buf.empty());
+
+    /* Contexts reserve the header before writing. */
+    {
+        auto ctx = msg_buf.context();
+        assert(ctx.max == 63);
+        msg_buf.write_n("hello", 5);
+    }
+    assert(msg_buf.put_message("world!", 6));
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 5 and std::string(buf.data(), len) == "hello");
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 6 and std::string(buf.data(), len) == "world!");
+
+    /* Longer lengths take more header bytes (padded, from contexts). */
+    Coral::InlineMessageBuffer<1024, char> big;
+    static_assert(big.max_header == 2);
+    std::string text(200, 'x');
+    assert(big.put_message(text.data(), text.size()));
+    assert(big.put_message("y", 1));
+    {
+        auto ctx = big.context();
+        assert(ctx.max == 1024 - (2 + 200) - (1 + 1) - 2);
+        big.write_n("z", 1);
+    }
+    std::array<char, 1024> out = {};
+    assert(big.get_message(out.data(), len));
+    assert(len == 200);
+    assert(big.get_message(out.data(), len));
+    assert(len == 1);
+    assert(big.get_message(out.data(), len));
+    assert(len == 1);
+    assert(out[0] == 'z');
+    assert(big.empty());
+
+    /* Overwrite mode evicts whole messages by their inline headers. */
+    msg_buf.set_overwrite();
+    for (char i = 0; i < 20; i++)
+    {
+        buf.fill(i);
+        assert(msg_buf.put_message(buf.data(), 7));
+    }
+    assert(msg_buf.evicted() == 12);
+    for (char i = 12; i < 20; i++)
+    {
+        assert(msg_buf.get_message(buf.data(), len));
+        assert(len == 7 and buf[0] == i);
+    }
+    assert(msg_buf.empty());
+}
+
+void log_test(void)
+{
+    Coral::MessageBuffer<32, 4, char> msg_buf;
+    std::array<char, 32> buf = {};
+    std::size_t len = 0;
+
+    /* Move the cursors so the next message wraps. */
+    assert(msg_buf.put_message(buf.data(), 20));
+    assert(msg_buf.get_message(buf.data(), len));
+    {
+        auto ctx = msg_buf.context();
+        ctx.log("%s-%d", "wrapped", 1234567);
+    }
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(std::string(buf.data(), len) == "wrapped-1234567");
+
+    /* Output past the space left is truncated (wherever the ring wraps). */
+    assert(msg_buf.put_message("0123456789", 10));
+    {
+        auto ctx = msg_buf.context();
+        assert(ctx.max == 22);
+        ctx.log("%s", "abcdefghijklmnopqrstuvwxyz");
+    }
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(std::string(buf.data(), len) == "0123456789");
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(std::string(buf.data(), len) == "abcdefghijklmnopqrstuv");
+    assert(msg_buf.empty());
+
+    Coral::MessageBuffer<32, 4, char> head_buf;
+    assert(head_buf.put_message(buf.data(), 28));
+    assert(head_buf.get_message(buf.data(), len));
+    assert(head_buf.put_message("01", 2));
+    {
+        auto ctx = head_buf.context();
+        ctx.log("%s%s", "abcdefghijklmnopqrstuvwxyz", "ABCDEFGHIJKLMN");
+    }
+    assert(head_buf.get_message(buf.data(), len));
+    assert(head_buf.get_message(buf.data(), len));
+    assert(std::string(buf.data(), len) == "abcdefghijklmnopqrstuvwxyzABCD");
+
+    /* Neither end holds it alone, but the whole text still fits. */
+    Coral::MessageBuffer<32, 4, char> split_buf;
+    assert(split_buf.put_message(buf.data(), 16));
+    assert(split_buf.get_message(buf.data(), len));
+    {
+        auto ctx = split_buf.context();
+        ctx.log("%s-%s", "0123456789", "abcdefghij");
+    }
+    assert(split_buf.get_message(buf.data(), len));
+    assert(std::string(buf.data(), len) == "0123456789-abcdefghij");
+
+    /* Longer output than the scratch array, formatted in the head. */
+    Coral::MessageBuffer<1024, 4, char> long_buf;
+    std::string long_text(500, 'x');
+    std::array<char, 1024> long_out;
+    assert(long_buf.put_message(long_text.data(), 600));
+    assert(long_buf.get_message(long_out.data(), len));
+    {
+        auto ctx = long_buf.context();
+        ctx.log("%s", long_text.c_str());
+    }
+    assert(long_buf.get_message(long_out.data(), len));
+    assert(std::string(long_out.data(), len) == long_text);
+
+    /* Successive calls fill what's left, without clearing the buffer. */
+    assert(msg_buf.put_message("0123456789", 10));
+    {
+        auto ctx = msg_buf.context();
+        ctx.log("%s", "abcdefghij");
+        ctx.log("%s", "klmnopqrst");
+        ctx.log("%s", "uvwxyz");
+    }
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(std::string(buf.data(), len) == "0123456789");
+    assert(msg_buf.get_message(buf.data(), len));
+    /* (Truncated output that doesn't wrap is terminated.) */
+    assert(std::string(buf.data(), len) == "abcdefghijklmnopqrstu");
+}
+
+void rollback_test(void)
+{
+    Coral::MessageBuffer<32, 4, char> msg_buf;
+    std::array<char, 32> buf = {};
+    std::size_t len = 0;
+
+    /* An aborted message leaves queued ones as they were. */
+    assert(msg_buf.put_message("abc", 3));
+    {
+        auto ctx = msg_buf.context();
+        msg_buf.write_n("hello", 5);
+        ctx.abort();
+    }
+    assert(msg_buf.rejected() == 1);
+
+    /* So does one that doesn't fit (checked before writing). */
+    assert(msg_buf.put_message("0123456789", 10));
+    {
+        auto ctx = msg_buf.context();
+        assert(ctx.max == 19);
+        msg_buf.write_n("abcdefghijklmnop", 16);
+        assert(ctx.remaining() == 3);
+        assert(not ctx.overflowed());
+        msg_buf.write_n("qrstu", 5);
+        assert(ctx.overflowed());
+        msg_buf.write_n("q", 1);
+    }
+    assert(msg_buf.rejected() == 2);
+
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 3 and std::string(buf.data(), len) == "abc");
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 10 and std::string(buf.data(), len) == "0123456789");
+    assert(msg_buf.empty());
+
+    /* The buffer carries on from where the last message ended. */
+    {
+        auto ctx = msg_buf.context();
+        msg_buf.write_n("xyz", 3);
+    }
+    assert(msg_buf.get_message(buf.data(), len));
+    assert(len == 3 and std::string(buf.data(), len) == "xyz");
+
+    /* Inline lengths (the reserved header is rolled back too). */
+    Coral::InlineMessageBuffer<16, char> inline_buf;
+    assert(inline_buf.put_message("abcd", 4));
+    {
+        auto ctx = inline_buf.context();
+        assert(ctx.max == 10);
+        inline_buf.write_n("0123456789a", 11);
+    }
+    assert(inline_buf.rejected() == 1);
+    {
+        auto ctx = inline_buf.context();
+        inline_buf.write_n("hi", 2);
+    }
+    assert(inline_buf.get_message(buf.data(), len));
+    assert(len == 4 and std::string(buf.data(), len) == "abcd");
+    assert(inline_buf.get_message(buf.data(), len));
+    assert(len == 2 and std::string(buf.data(), len) == "hi");
+    assert(inline_buf.empty());
+
+    /* In overwrite mode, messages already overwritten are evicted. */
+    Coral::MessageBuffer<16, 4, char> overwrite_buf;
+    overwrite_buf.set_overwrite();
+    assert(overwrite_buf.put_message("0123456789", 10));
+    assert(overwrite_buf.put_message("ab", 2));
+    {
+        auto ctx = overwrite_buf.context();
+        overwrite_buf.write_n("xxxxxxxx", 8);
+        ctx.abort();
+    }
+    assert(overwrite_buf.rejected() == 1);
+    assert(overwrite_buf.evicted() == 1);
+    assert(overwrite_buf.get_message(buf.data(), len));
+    assert(len == 2 and std::string(buf.data(), len) == "ab");
+    assert(overwrite_buf.empty());
+
+    /* Contexts beyond the message count limit are rejected too. */
+    Coral::MessageBuffer<64, 2, char> count_buf;
+    for (auto word : {"first", "second", "third"})
+    {
+        auto ctx = count_buf.context();
+        ctx.log("%s", word);
+    }
+    {
+        auto ctx = count_buf.context();
+        assert(ctx.max == 0);
+    }
+    assert(count_buf.rejected() == 2);
+    assert(count_buf.get_message(buf.data(), len));
+    assert(len == 5 and std::string(buf.data(), len) == "first");
+    assert(count_buf.get_message(buf.data(), len));
+    assert(len == 6 and std::string(buf.data(), len) == "second");
+    assert(count_buf.empty());
+
+    /* Unless the oldest can be evicted for them (overwrite mode). */
+    count_buf.set_overwrite();
+    for (auto word : {"first", "second", "third"})
+    {
+        auto ctx = count_buf.context();
+        ctx.log("%s", word);
+    }
+    assert(count_buf.rejected() == 2);
+    assert(count_buf.evicted() == 1);
+    assert(count_buf.get_message(buf.data(), len));
+    assert(len == 6 and std::string(buf.data(), len) == "second");
+    assert(count_buf.get_message(buf.data(), len));
+    assert(len == 5 and std::string(buf.data(), len) == "third");
+    assert(count_buf.empty());
+}
+
+static std::string text(const Coral::RingSegments<const char> &message)
+{
+    std::string result(message.size(), '\0');
+    message.copy_to(result.data(), 0, result.size());
+    return result;
+}
+
+void batch_test(void)
+{
+    Coral::MessageBuffer<32, 4, char> msg_buf;
+    std::array<Coral::RingSegments<const char>, 4> views;
+    std::array<char, 32> buf = {};
+    std::size_t len = 0;
+
+    /* Messages are viewed in place, up to a total size. */
+    assert(msg_buf.put_message("abc", 3));
+    assert(msg_buf.put_message("defgh", 5));
+    assert(msg_buf.put_message("ij", 2));
+    assert(msg_buf.get_messages(views, 8) == 2);
+    assert(text(views[0]) == "abc");
+    assert(text(views[1]) == "defgh");
+    assert(not msg_buf.get_message(buf.data(), len));
+    assert(msg_buf.get_messages(views) == 3);
+    assert(text(views[2]) == "ij");
+
+    /* Released together. */
+    assert(msg_buf.release(2));
+    assert(msg_buf.get_messages(views) == 1);
+    assert(text(views[0]) == "ij");
+
+    /* Views cover both ends of the ring (and go straight to writev). */
+    std::string bulk(20, 'k');
+    assert(msg_buf.put_message(bulk.data(), bulk.size()));
+    assert(msg_buf.put_message("lmnop", 5));
+    assert(msg_buf.get_messages(views) == 3);
+    assert(not views[2].contiguous());
+    assert(text(views[2]) == "lmnop");
+
+    std::array<struct iovec, 4> iovecs;
+    std::size_t regions = 0;
+    assert(Coral::gather_iovecs(views.data(), 3, std::span(iovecs).first(3),
+                                regions) == 2);
+    assert(regions == 2);
+    assert(Coral::gather_iovecs(views.data(), 3, std::span(iovecs),
+                                regions) == 4);
+    assert(regions == 3);
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    assert(writev(fds[1], iovecs.data(), 4) == 27);
+    std::string sent(27, '\0');
+    assert(read(fds[0], sent.data(), sent.size()) == 27);
+    assert(sent == "ij" + bulk + "lmnop");
+    close(fds[0]);
+    close(fds[1]);
+
+    assert(msg_buf.release(3));
+    assert(msg_buf.empty());
+    assert(not msg_buf.release(1));
+
+    /* The oldest message is always viewed. */
+    assert(msg_buf.put_message("abcdef", 6));
+    assert(msg_buf.get_messages(views, 2) == 1);
+    assert(text(views[0]) == "abcdef");
+    assert(msg_buf.release(1));
+
+    /* Viewed messages aren't evicted (in overwrite mode). */
+    Coral::MessageBuffer<16, 4, char> overwrite_buf;
+    overwrite_buf.set_overwrite();
+    assert(overwrite_buf.put_message("0123456789", 10));
+    assert(overwrite_buf.put_message("ab", 2));
+    assert(overwrite_buf.get_messages(views) == 2);
+    assert(not overwrite_buf.put_message("cdefgh", 6));
+    {
+        auto ctx = overwrite_buf.context();
+        assert(ctx.max == 4);
+        ctx.abort();
+    }
+    assert(overwrite_buf.release(1));
+    assert(overwrite_buf.put_message("cdefghijklmnop", 14));
+    assert(not overwrite_buf.put_message("q", 1));
+    assert(overwrite_buf.evicted() == 0);
+    assert(overwrite_buf.release(1));
+    assert(overwrite_buf.put_message("qrs", 3));
+    assert(overwrite_buf.evicted() == 1);
+
+    /* Inline lengths. */
+    Coral::InlineMessageBuffer<16, char> inline_buf;
+    assert(inline_buf.put_message("abc", 3));
+    {
+        auto ctx = inline_buf.context();
+        inline_buf.write_n("de", 2);
+    }
+    assert(inline_buf.get_messages(views) == 2);
+    assert(text(views[0]) == "abc");
+    assert(text(views[1]) == "de");
+    assert(inline_buf.release(2));
+    assert(inline_buf.empty());
+}
+
 int main(void)
 {
     using namespace Coral;
@@ -97,6 +549,15 @@ int main(void)
     loopback_test<std::float64_t, std::endian::little>(circ_buf, -3.0f64);
 #endif
 
+    array_test<uint16_t, std::endian::big>(circ_buf);
+    array_test<uint16_t, std::endian::little>(circ_buf);
+    array_test<int32_t, std::endian::big>(circ_buf);
+    array_test<uint32_t, std::endian::little>(circ_buf);
+    array_test<uint64_t, std::endian::big>(circ_buf);
+    array_test<float, std::endian::big>(circ_buf);
+    array_test<double, std::endian::big>(circ_buf);
+    array_test<uint8_t, std::endian::big>(circ_buf);
+
     struct_test<>(circ_buf);
     struct_test<std::endian::big>(circ_buf);
     struct_test<std::endian::little>(circ_buf);
@@ -175,14 +636,21 @@ int main(void)
     }
     assert(not msg_buf.empty());
 
-    /* Buffer too small. */
+    /* Buffer too small (the message is truncated, and terminated). */
     MessageBuffer<8, 1, char> msg_buf2;
     msg_buf2.clear();
     {
         auto ctx = msg_buf2.context();
         ctx.log("Hello, world! %d %s\n", 5, "test");
     }
-    assert(msg_buf2.empty());
+    assert(msg_buf2.get_message(buf.data(), len));
+    assert(std::string(buf.data(), len) == "Hello, ");
+
+    overwrite_test();
+    inline_test();
+    log_test();
+    rollback_test();
+    batch_test();
 
     return 0;
 }
@@ -0,0 +1,134 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <cassert>
+#include <cstring>
+
+/* internal */
+#include "buffer/MirroredStorage.h"
+#include "buffer/PcBuffer.h"
+#include "buffer/cobs/Decoder.h"
+#include "buffer/cobs/Encoder.h"
+
+using namespace Coral;
+
+#ifdef __linux__
+
+static constexpr std::size_t depth = mirrored_page_size;
+
+using Circular = CircularBuffer<depth, uint8_t, 1, MirroredStorage>;
+using Buffer = PcBuffer<depth, uint8_t, 1, NoopLock, MirroredStorage>;
+
+static_assert(Buffer::Mirrored);
+static_assert(not PcBuffer<depth, uint8_t>::Mirrored);
+
+void test_aliasing(void)
+{
+    Circular circ;
+
+    /* Both views of the storage refer to the same memory. */
+    auto head = const_cast<uint8_t *>(circ.head());
+    head[0] = 0xaa;
+    assert(head[depth] == 0xaa);
+    head[depth + 1] = 0x55;
+    assert(head[1] == 0x55);
+
+    /* A wrapped write is a single copy, and reads back linearly. */
+    std::array<uint8_t, 64> data;
+    for (std::size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = i;
+    }
+
+    circ.commit_write(depth - 16);
+    circ.consume(depth - 16);
+    circ.write_n(data.data(), data.size());
+
+    auto segments = circ.peek_read(data.size());
+    assert(segments.contiguous());
+    assert(std::memcmp(segments.first.data(), data.data(), data.size()) ==
+           0);
+
+    std::array<uint8_t, 64> out = {};
+    circ.read_n(out.data(), out.size());
+    assert(out == data);
+}
+
+void test_wrapped_read(void)
+{
+    Buffer buf;
+
+    /* Move the cursors close to the end of the underlying pages. */
+    assert(buf.push_n(nullptr, depth - 10));
+    assert(buf.pop_all() == depth - 10);
+
+    const char *message = "Hello, world! This message wraps.";
+    std::size_t length = std::strlen(message);
+    assert(buf.push_n(reinterpret_cast<const uint8_t *>(message), length));
+
+    /* A wrapped region comes back as one span. */
+    auto readable = buf.peek_read();
+    assert(readable.size() == length);
+    assert(readable.contiguous());
+    assert(std::memcmp(readable.first.data(), message, length) == 0);
+
+    /* Reservations that wrap are also contiguous. */
+    auto reserved = buf.reserve_write();
+    assert(reserved.size() == depth - length);
+    assert(reserved.contiguous());
+
+    /* Wrapped data can be COBS encoded in-place. */
+    Cobs::MessageEncoder encoder(readable.first.data(), readable.size());
+    PcBuffer<depth, uint8_t> encoded;
+    assert(encoder.encode(encoded));
+    assert(buf.consume(length));
+    assert(buf.empty());
+
+    bool seen = false;
+    Cobs::MessageDecoder<depth, uint8_t> decoder(
+        [&](const std::array<uint8_t, depth> &data, std::size_t size) {
+            assert(size == length);
+            assert(std::memcmp(data.data(), message, length) == 0);
+            seen = true;
+        });
+    decoder.dispatch(encoded);
+    assert(seen);
+}
+
+void test_page_size(void)
+{
+    /* Sizes that aren't whole (system) pages are refused, not mapped. */
+    assert(system_page_size() % mirrored_page_size == 0);
+    assert(not mirrored_map(system_page_size() / 2));
+    assert(not mirrored_map(0));
+
+    void *base = mirrored_map(system_page_size());
+    assert(base);
+    mirrored_unmap(base, system_page_size());
+}
+
+int main(void)
+{
+    test_page_size();
+
+    /* E.g. 16K or 64K pages. */
+    if (not MirroredStorage<depth, uint8_t, 1>::supported())
+    {
+        return 0;
+    }
+
+    test_aliasing();
+    test_wrapped_read();
+    return 0;
+}
+
+#else
+
+int main(void)
+{
+    return 0;
+}
+
+#endif
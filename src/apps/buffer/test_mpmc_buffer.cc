@@ -0,0 +1,159 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <cassert>
+#include <thread>
+#include <vector>
+
+/* internal */
+#include "buffer/MpmcBuffer.h"
+
+using namespace Coral;
+
+struct Record
+{
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+static constexpr std::size_t depth = 100;
+
+void test_basic(void)
+{
+    MpmcBuffer<depth, uint16_t> buf;
+    assert(buf.empty());
+
+    for (uint16_t i = 0; i < depth; i++)
+    {
+        assert(buf.push(i));
+    }
+    assert(buf.full());
+    assert(buf.space_available() == 0);
+    assert(not buf.push(0, true));
+    assert(buf.write_dropped() == 1);
+
+    uint16_t val;
+    for (uint16_t i = 0; i < depth; i++)
+    {
+        assert(buf.pop(val));
+        assert(val == i);
+    }
+    assert(not buf.pop(val));
+
+    /* Multi-element operations are all-or-nothing. */
+    std::array<uint16_t, depth> data;
+    for (uint16_t i = 0; i < depth; i++)
+    {
+        data[i] = i;
+    }
+    assert(buf.push_n(data.data(), depth / 2));
+    assert(not buf.push(data));
+    assert(not buf.push_n(data.data(), depth + 1, true));
+    assert(buf.write_dropped() == depth + 2);
+    assert(buf.try_push_n(data) == depth / 2);
+    assert(buf.full());
+
+    std::array<uint16_t, depth> out = {};
+    assert(buf.pop_n(out.data(), depth / 2));
+    assert(not buf.pop_n(out.data(), depth));
+    assert(buf.try_pop_n(out) == depth / 2);
+    assert(buf.try_pop_n(out) == 0);
+
+    assert(buf.try_push_n(data.data(), 10) == 10);
+    assert(buf.pop_all() == 10);
+    assert(buf.empty());
+}
+
+void test_threads(std::size_t producers, std::size_t consumers)
+{
+    static constexpr uint32_t per_producer = 100000;
+    static constexpr std::size_t chunk = 3;
+
+    MpmcBuffer<depth, Record> buf;
+
+    std::vector<std::thread> threads;
+    for (uint32_t id = 0; id < producers; id++)
+    {
+        threads.emplace_back([&buf, id]() {
+            uint32_t sequence = 0;
+            while (sequence < per_producer)
+            {
+                /* Alternate single pushes and (atomic) chunks. */
+                if (sequence % 2)
+                {
+                    buf.push_blocking({id, sequence++});
+                    continue;
+                }
+
+                std::array<Record, chunk> records;
+                std::size_t count = std::min<std::size_t>(
+                    chunk, per_producer - sequence);
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    records[i] = {id, sequence++};
+                }
+                while (not buf.push_n(records.data(), count))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::atomic<uint64_t> total = 0;
+    std::atomic<uint64_t> sum = 0;
+    std::vector<std::thread> readers;
+    const uint64_t expected = per_producer * producers;
+
+    for (std::size_t i = 0; i < consumers; i++)
+    {
+        readers.emplace_back([&]() {
+            std::vector<uint32_t> next(producers, 0);
+            std::array<Record, 16> records;
+
+            while (total.load() < expected)
+            {
+                std::size_t count = buf.try_pop_n(records);
+                for (std::size_t j = 0; j < count; j++)
+                {
+                    auto &record = records[j];
+
+                    /* Each producer's records are seen in order. */
+                    assert(record.sequence >= next[record.producer]);
+                    next[record.producer] = record.sequence + 1;
+                    sum += record.sequence;
+                }
+                total += count;
+                if (not count)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (auto &thread : readers)
+    {
+        thread.join();
+    }
+
+    assert(total == expected);
+    assert(sum == producers * (uint64_t(per_producer) *
+                               (per_producer - 1) / 2));
+    assert(buf.empty());
+}
+
+int main(void)
+{
+    test_basic();
+    test_threads(1, 1);
+    test_threads(4, 1);
+    test_threads(4, 3);
+    return 0;
+}
@@ -6,8 +6,11 @@
 #include <cassert>
 #include <limits>
 #include <stdio.h>
+#include <string>
+#include <thread>
 
 /* internal */
+#include "Locks.h"
 #include "common.h"
 
 using Buffer = PcBuffer<depth, element_t>;
@@ -41,11 +44,9 @@ void test_basic(Buffer &buf)
         val++;
     }
 
-    /*
-    PcBufferStats stats;
-    buf.state.poll_stats(stats);
-    assert(stats.high_watermark == depth);
-    */
+    auto metrics = buf.metrics();
+    assert(metrics.high_watermark == depth);
+    assert(metrics.data == depth);
 
     /* Should not be able to add any more data. */
     assert(!buf.push(val));
@@ -118,6 +119,205 @@ void test_drop_data(Buffer &buf)
     buf.pop_all();
 }
 
+void test_zero_copy(void)
+{
+    std::size_t data_calls = 0;
+    std::size_t space_calls = 0;
+    Buffer buf(
+        false, [&space_calls](Buffer *) { space_calls++; },
+        [&data_calls](Buffer *) { data_calls++; });
+
+    /* Move the cursors close to the end of the underlying array. */
+    constexpr std::size_t offset = depth - 24;
+    assert(buf.push_n(nullptr, offset));
+    assert(buf.pop_all() == offset);
+    data_calls = 0;
+    space_calls = 0;
+
+    /* A reservation that wraps is split into two segments. */
+    auto reserved = buf.reserve_write(100);
+    assert(reserved.size() == 100);
+    assert(reserved.first.size() == 24);
+    assert(reserved.second.size() == 76);
+    assert(not reserved.contiguous());
+
+    element_t val = 0;
+    for (auto &elem : reserved.first)
+    {
+        elem = val++;
+    }
+    for (auto &elem : reserved.second)
+    {
+        elem = val++;
+    }
+
+    /* Nothing is visible until the write is committed. */
+    assert(buf.empty());
+    assert(buf.peek_read().empty());
+    assert(buf.commit_write(100));
+    assert(data_calls == 1);
+    assert(buf.state.data_available() == 100);
+
+    /* Read the data back in-place. */
+    auto readable = buf.peek_read();
+    assert(readable.size() == 100);
+    assert(readable.first.data() == reserved.first.data());
+    assert(readable.second.data() == reserved.second.data());
+
+    val = 0;
+    for (auto elem : readable.first)
+    {
+        assert(elem == val++);
+    }
+    for (auto elem : readable.second)
+    {
+        assert(elem == val++);
+    }
+
+    /* Partial consumption. */
+    assert(buf.consume(50));
+    assert(space_calls == 1);
+    assert(buf.peek_read(10).size() == 10);
+    assert(buf.peek_read().size() == 50);
+    assert(buf.peek_read().contiguous());
+    assert(not buf.consume(51));
+    assert(buf.consume(50));
+    assert(buf.empty());
+
+    /* Reservations are limited to available space. */
+    assert(buf.push_n(nullptr, depth - 10));
+    assert(buf.reserve_write().size() == 10);
+    assert(not buf.commit_write(11, true));
+    assert(buf.state.write_dropped == 11);
+    assert(buf.commit_write(10));
+    assert(buf.full());
+    assert(buf.reserve_write().empty());
+}
+
+void test_service_thresholds(void)
+{
+    std::size_t data_calls = 0;
+    std::size_t space_calls = 0;
+
+    Buffer buf(
+        false, [&space_calls](Buffer *) { space_calls++; },
+        [&data_calls](Buffer *) { data_calls++; });
+
+    /* Defaults service on every operation. */
+    assert(buf.push('a'));
+    assert(buf.pop_all() == 1);
+    assert(data_calls == 1 and space_calls == 1);
+
+    /* Level-triggered high and low watermarks. */
+    buf.set_service_thresholds(4, depth - 2);
+    for (std::size_t i = 0; i < 5; i++)
+    {
+        assert(buf.push('a'));
+    }
+    assert(data_calls == 3);
+    assert(buf.state.data_suppressed == 3);
+
+    element_t elem;
+    for (std::size_t i = 0; i < 5; i++)
+    {
+        assert(buf.pop(elem));
+    }
+    assert(space_calls == 4);
+    assert(buf.state.space_suppressed == 2);
+
+    /* Edge-triggered, fires once per crossing. */
+    buf.state.reset();
+    buf.set_service_thresholds(4, 0, true);
+    for (std::size_t i = 0; i < 8; i++)
+    {
+        assert(buf.push('a'));
+    }
+    assert(data_calls == 4);
+    assert(buf.state.data_suppressed == 7);
+    assert(buf.pop_all() == 8);
+    assert(space_calls == 4);
+    assert(buf.try_push_n("abcd", 4) == 4);
+    assert(data_calls == 5);
+
+    /* Zero thresholds fire as the buffer stops being full. */
+    std::array<element_t, depth> fill = {};
+    buf.pop_all();
+    assert(buf.push(fill));
+    assert(buf.pop(elem));
+    assert(space_calls == 5);
+    assert(buf.pop(elem));
+    assert(space_calls == 5);
+}
+
+void test_arrays(void)
+{
+    Buffer buf;
+
+    std::array<uint16_t, 3> values = {0x0102, 0x0304, 0x0506};
+    assert(buf.push_array<std::endian::big>(
+        std::span<const uint16_t>(values)));
+    assert(buf.state.data_available() == sizeof(values));
+    assert(buf.peek() == 0x01);
+
+    std::array<uint16_t, 3> compare = {};
+    assert(buf.pop_array<std::endian::big>(std::span<uint16_t>(compare)));
+    assert(compare == values);
+    assert(not buf.pop_array<std::endian::big>(std::span<uint16_t>(compare)));
+
+    /* All-or-nothing. */
+    std::array<uint32_t, depth / sizeof(uint32_t) + 1> large = {};
+    assert(not buf.push_array<std::endian::little>(
+        std::span<const uint32_t>(large), true));
+    assert(buf.state.write_dropped == sizeof(large));
+    assert(buf.empty());
+}
+
+void test_metrics(void)
+{
+    static constexpr std::size_t large = 100000;
+
+    /* Watermarks and totals aren't truncated for deep buffers. */
+    PcBuffer<large, uint32_t> buf(
+        false, nullptr, [](PcBuffer<large, uint32_t> *) {});
+
+    auto start = buf.metrics();
+    assert(start.capacity == large);
+    assert(start.element_size == sizeof(uint32_t));
+
+    assert(buf.push_n(nullptr, large - 1));
+    assert(not buf.push_n(nullptr, 2, true));
+    assert(not buf.push_n(nullptr, large + 1, true));
+    assert(buf.pop_n(nullptr, 10));
+
+    auto end = buf.metrics();
+    assert(end.high_watermark == large - 1);
+    assert(end.write_total == large - 1);
+    assert(end.read_total == 10);
+    assert(end.data == large - 11);
+    assert(end.dropped_full == 2);
+    assert(end.dropped_oversize == large + 1);
+    assert(buf.state.write_dropped == large + 3);
+    assert(end.data_callbacks == 1);
+    assert(end.space_callbacks == 0);
+    assert(end.timestamp_ns >= start.timestamp_ns);
+
+    if (end.timestamp_ns > start.timestamp_ns)
+    {
+        assert(write_rate(start, end) > 0.0);
+        assert(read_rate(start, end) < write_rate(start, end));
+    }
+    assert(write_rate(end, end) == 0.0);
+
+    /* Ship the block over the wire. */
+    std::array<std::byte, BufferMetrics::size> raw;
+    end.encode<std::endian::big>(
+        reinterpret_cast<BufferMetrics::Buffer *>(raw.data()));
+    BufferMetrics decoded = {};
+    decoded.decode<std::endian::big>(
+        reinterpret_cast<BufferMetrics::Buffer *>(raw.data()));
+    assert(decoded == end);
+}
+
 void test_stream_interfaces(Buffer &buf)
 {
     /* Ensure the buffer is empty. */
@@ -133,6 +333,299 @@ void test_stream_interfaces(Buffer &buf)
     std::cout << buf;
 }
 
+void test_stream_buf(void)
+{
+    using Small = PcBuffer<16, char>;
+    Small buf;
+
+    /* Formatted output lands in the buffer once flushed. */
+    {
+        PcStreamBuf<Small> streambuf(buf);
+        std::ostream out(&streambuf);
+        out << "n=" << 42 << ' ' << std::flush;
+        assert(buf.peek_read().size() == 5);
+
+        /* Formatted input consumes what it parses. */
+        std::istream in(&streambuf);
+        std::string label;
+        int value = 0;
+        in >> label;
+        assert(label == "n=42");
+        in >> value;
+        assert(in.eof() and in.fail());
+    }
+    assert(buf.empty());
+
+    /* Bulk transfers straddle the wrap point. */
+    std::array<char, 10> skip;
+    assert(buf.push_n(skip.data(), skip.size()));
+    assert(buf.pop_n(skip.data(), skip.size()));
+    {
+        PcStreamBuf<Small> streambuf(buf);
+        std::ostream out(&streambuf);
+        std::istream in(&streambuf);
+
+        /* Writes stop (and fail) when the buffer is full. */
+        const char *data = "abcdefghijklmnopqrst";
+        out.write(data, 20);
+        assert(out.bad());
+        assert(buf.full());
+
+        std::array<char, 16> read = {};
+        in.read(read.data(), read.size());
+        assert(in.gcount() == 16);
+        assert(std::string(read.data(), 16) == std::string(data, 16));
+        assert(buf.empty());
+    }
+
+    /* Byte streams. */
+    PcBuffer<16> bytes;
+    {
+        PcStreamBuf<PcBuffer<16>> streambuf(bytes);
+        byte_ostream out(&streambuf);
+        out.put(std::byte{0xab}).put(std::byte{0xcd}).flush();
+
+        byte_istream in(&streambuf);
+        std::byte first;
+        assert(in.get(first));
+        assert(first == std::byte{0xab});
+    }
+    std::byte last;
+    assert(bytes.pop(last));
+    assert(last == std::byte{0xcd});
+
+    /* Stream operators copy only what fits, across the wrap. */
+    assert(buf.push_n(skip.data(), skip.size()));
+    assert(buf.pop_n(skip.data(), skip.size()));
+    std::stringstream source("0123456789abcdefXYZ");
+    source >> buf;
+    assert(buf.full());
+    std::stringstream sink;
+    sink << buf;
+    assert(sink.str() == "0123456789abcdef");
+    assert(buf.empty());
+
+    /* Blocking stream buffers wait for each other. */
+    using Shared = PcBuffer<16, char, 1, MutexLock<>>;
+    Shared shared;
+    std::thread consumer([&shared]() {
+        PcStreamBuf<Shared> streambuf(shared, true);
+        std::istream in(&streambuf);
+        for (int i = 0; i < 100; i++)
+        {
+            int value = -1;
+            in >> value;
+            assert(value == i);
+        }
+    });
+    {
+        PcStreamBuf<Shared> streambuf(shared, true);
+        std::ostream out(&streambuf);
+        for (int i = 0; i < 100; i++)
+        {
+            out << i << '\n' << std::flush;
+        }
+    }
+    consumer.join();
+}
+
+void test_overwrite(void)
+{
+    PcBuffer<8, char> buf;
+    buf.set_overwrite();
+
+    /* Writes to a full buffer evict the oldest elements. */
+    for (char i = 0; i < 12; i++)
+    {
+        assert(buf.push(i));
+    }
+    assert(buf.full());
+    assert(buf.metrics().data == 8);
+
+    std::array<char, 4> vals;
+    assert(buf.pop(vals));
+    assert(vals[0] == 4 and vals[3] == 7);
+
+    assert(buf.push_n("abcdefg", 7));
+    assert(buf.try_push_n("0123456789", 10) == 8);
+
+    /* Larger writes are still dropped, blocking writes never block. */
+    assert(not buf.push_n("0123456789", 9, true));
+    buf.push_blocking('x');
+    buf.push_n_blocking("yz", 2);
+
+    std::array<char, 8> all;
+    assert(buf.pop(all));
+    assert(std::string(all.data(), all.size()) == "34567xyz");
+
+    BufferMetrics metrics = buf.metrics();
+    assert(metrics.dropped_evicted == 4 + 3 + 8 + 1 + 2);
+    assert(metrics.dropped_oversize == 9);
+    assert(metrics.dropped_full == 0);
+
+    /* Disabled again, writes to a full buffer are rejected. */
+    buf.set_overwrite(false);
+    assert(buf.push_n("abcdefgh", 8));
+    assert(not buf.push('!', true));
+    assert(buf.metrics().dropped_full == 1);
+}
+
+void test_poll_metrics(void)
+{
+    PcBufferState state(4);
+    uint64_t high_watermark;
+    uint64_t write_dropped;
+
+    assert(state.increment_data(true, 3));
+    assert(not state.increment_data(true, 2));
+    assert(not state.increment_data(true, 5));
+    state.poll_metrics(high_watermark, write_dropped);
+    assert(high_watermark == 3);
+    assert(write_dropped == 2 + 5);
+
+    /* The total and its causes are reset together. */
+    assert(not state.increment_data(true, 2));
+    assert(state.write_dropped == state.dropped_full + state.dropped_oversize);
+    assert(state.dropped_full == 2);
+    assert(state.dropped_oversize == 0);
+}
+
+void test_framing(void)
+{
+    PcBuffer<16, char> buf;
+    std::array<char, 16> out = {};
+    std::size_t offset = 0;
+
+    /* Wrap the data around the end of the ring. */
+    assert(buf.push_n("0123456789", 10));
+    assert(buf.pop_n(out.data(), 10));
+    assert(buf.push_n("ab\ncdefg\nhij", 12));
+
+    /* Search both segments without consuming anything. */
+    assert(buf.find('\n', offset));
+    assert(offset == 2);
+    assert(buf.find('\n', offset, 3));
+    assert(offset == 8);
+    assert(buf.find('j', offset));
+    assert(offset == 11);
+    assert(not buf.find('z', offset));
+    assert(not buf.find('a', offset, 1));
+
+    assert(buf.peek_n(out.data(), 4, 6) == 4);
+    assert(std::string(out.data(), 4) == "fg\nh");
+    assert(buf.peek_n(out.data(), 16, 10) == 2);
+    assert(buf.peek_n(out.data(), 4, 12) == 0);
+    assert(buf.peek_read().size() == 12);
+
+    /* Pop whole frames, then what's left of a partial one. */
+    assert(buf.pop_until('\n', out.data(), out.size()) == 3);
+    assert(std::string(out.data(), 3) == "ab\n");
+    assert(buf.pop_until('\n', out.data(), 3) == 3);
+    assert(std::string(out.data(), 3) == "cde");
+    assert(buf.pop_until('\n', out.data(), out.size()) == 3);
+    assert(std::string(out.data(), 3) == "fg\n");
+    assert(buf.pop_until('\n', out.data(), out.size()) == 3);
+    assert(std::string(out.data(), 3) == "hij");
+    assert(buf.empty());
+    assert(buf.pop_until('\n', out.data(), out.size()) == 0);
+
+    /* Non-byte elements. */
+    PcBuffer<8, uint32_t> words;
+    std::array<uint32_t, 6> vals = {1, 2, 3, 0, 5, 0};
+    assert(words.push(vals));
+    assert(words.find(0u, offset));
+    assert(offset == 3);
+    assert(words.pop_until(0u, vals.data(), vals.size()) == 4);
+    assert(vals[2] == 3 and vals[3] == 0);
+}
+
+void test_vectored(void)
+{
+    PcBuffer<16, char> buf;
+    std::size_t calls = 0;
+    buf.set_data_available([&calls](PcBuffer<16, char> *buf) {
+        (void)buf;
+        calls++;
+    });
+    std::array<char, 16> out = {};
+
+    /* Wrap the pieces around the end of the ring. */
+    assert(buf.push_n("0123456789", 10));
+    assert(buf.pop_n(out.data(), 10));
+    calls = 0;
+
+    std::string header = "HDR:", payload = "payload", trailer = "!\n";
+    assert(buf.push_v({header, {}, payload, trailer}));
+    assert(calls == 1);
+    assert(buf.metrics().data == 13);
+
+    /* Pieces that don't fit are rejected (and nothing is written). */
+    assert(not buf.push_v({header, payload}, true));
+    assert(calls == 1);
+    assert(buf.metrics().data == 13);
+    assert(buf.metrics().dropped_full == 11);
+
+    std::array<char, 4> head;
+    std::array<char, 7> body;
+    std::array<char, 3> tail;
+    assert(not buf.pop_v({head, body, tail}));
+    assert(buf.metrics().data == 13);
+
+    std::span<char> pieces[] = {head, body, std::span(tail).first(2)};
+    assert(buf.pop_v(pieces));
+    assert(std::string(head.data(), head.size()) == header);
+    assert(std::string(body.data(), body.size()) == payload);
+    assert(std::string(tail.data(), 2) == trailer);
+    assert(buf.empty());
+}
+
+void test_struct(void)
+{
+    PcBuffer<24, uint8_t> buf;
+    std::size_t calls = 0;
+    buf.set_data_available([&calls](PcBuffer<24, uint8_t> *buf) {
+        (void)buf;
+        calls++;
+    });
+
+    BufferState state = {};
+    state.write_cursor = 0x01020304;
+    state.read_cursor = 5;
+    state.read_count = 6;
+    state.write_count = 7;
+
+    std::array<uint8_t, BufferState::size> raw;
+    BufferState out = {};
+    std::size_t dropped = 0;
+
+    /* Contiguous, then straddling the end of the ring. */
+    for (std::size_t start : {0, 20})
+    {
+        std::array<uint8_t, 20> fill = {};
+        assert(buf.try_push_n(fill.data(), start) == start);
+        assert(buf.try_pop_n(fill.data(), start) == start);
+        calls = 0;
+
+        assert(buf.push_struct<std::endian::big>(state));
+        assert(calls == 1);
+        assert(buf.metrics().data == BufferState::size);
+
+        /* Encoded in the requested byte order. */
+        assert(buf.peek_n(raw.data(), raw.size()) == raw.size());
+        assert(raw[0] == 1 and raw[3] == 4 and raw[7] == 5);
+
+        /* No room for another. */
+        assert(not buf.push_struct<std::endian::big>(state, true));
+        dropped += BufferState::size;
+        assert(buf.metrics().dropped_full == dropped);
+
+        assert(buf.pop_struct<std::endian::big>(out));
+        assert(out == state);
+        assert(buf.empty());
+        assert(not buf.pop_struct<std::endian::big>(out));
+    }
+}
+
 int main(void)
 {
     Buffer buf(
@@ -148,6 +641,16 @@ int main(void)
     test_drop_data(buf2);
 
     test_stream_interfaces(buf2);
+    test_zero_copy();
+    test_service_thresholds();
+    test_arrays();
+    test_metrics();
+    test_stream_buf();
+    test_overwrite();
+    test_poll_metrics();
+    test_framing();
+    test_vectored();
+    test_struct();
 
     char data = 'x';
     for (std::size_t i = 0; i < depth; i++)
@@ -0,0 +1,81 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+/* internal */
+#include "buffer/CircularBuffer.h"
+
+using namespace Coral;
+
+template <std::size_t depth> void test_wrap(void)
+{
+    RingCursor<depth> cursor;
+    assert(cursor.index() == 0);
+
+    /* Advance well past where a 32-bit cursor would overflow. */
+    static constexpr uint64_t limit = (uint64_t(1) << 32) + depth * 3;
+    while (cursor.total() + depth <= limit)
+    {
+        cursor.advance(depth);
+        assert(cursor.index() == 0);
+    }
+
+    for (std::size_t i = 0; i < depth * 2; i++)
+    {
+        assert(cursor.index() == cursor.total() % depth);
+        cursor.advance(1);
+    }
+    assert(cursor.total() > UINT32_MAX);
+
+    cursor.advance(depth - 1);
+    assert(cursor.index() == cursor.total() % depth);
+
+    cursor.reset();
+    assert(cursor.index() == 0 and cursor.total() == 0);
+}
+
+template <std::size_t depth> void test_buffer(void)
+{
+    CircularBuffer<depth, uint8_t> buf;
+
+    std::array<uint8_t, depth> data;
+    for (std::size_t i = 0; i < depth; i++)
+    {
+        data[i] = static_cast<uint8_t>(i);
+    }
+
+    /* Stream through the buffer at odd offsets. */
+    std::array<uint8_t, depth> compare;
+    for (std::size_t i = 1; i < depth; i += 7)
+    {
+        buf.write_n(data.data(), i);
+        buf.read_n(compare.data(), i);
+        assert(std::equal(data.begin(), data.begin() + i, compare.begin()));
+    }
+
+    auto state = buf.snapshot();
+    assert(state.write_cursor == buf.total_written());
+    assert(state.read_cursor == buf.total_read());
+    assert(state.write_count == state.read_count);
+    assert(buf.write_count() == state.write_count);
+    assert(buf.write_count() == 0);
+}
+
+int main(void)
+{
+    static_assert(RingCursor<1024>::power_of_two);
+    static_assert(not RingCursor<1000>::power_of_two);
+
+    test_wrap<1024>();
+    test_wrap<1000>();
+
+    test_buffer<64>();
+    test_buffer<100>();
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+/* internal */
+#include "buffer/SpscBuffer.h"
+
+using namespace Coral;
+
+static constexpr std::size_t depth = 1000;
+
+using Buffer = SpscBuffer<depth, uint32_t>;
+
+void test_basic(Buffer &buf)
+{
+    assert(buf.empty());
+    assert(buf.head());
+
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        assert(buf.push(i));
+    }
+    assert(buf.full());
+    assert(not buf.push(0));
+    assert(not buf.push(0, true));
+    assert(buf.write_dropped() == 1);
+
+    uint32_t val;
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        assert(buf.peek() == i);
+        assert(buf.pop(val));
+        assert(val == i);
+    }
+    assert(buf.empty());
+    assert(not buf.pop(val));
+
+    /* Wrap the cursors, all-or-nothing and partial transfers. */
+    std::array<uint32_t, depth> data;
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        data[i] = i;
+    }
+    assert(buf.push_n(data.data(), depth / 2));
+    assert(buf.pop_all() == depth / 2);
+    assert(buf.push(data));
+    assert(not buf.push_n(data.data(), 1));
+    assert(buf.try_push_n(data) == 0);
+
+    std::array<uint32_t, depth> out = {};
+    assert(buf.pop(out));
+    assert(out == data);
+    assert(buf.try_pop_n(out) == 0);
+
+    assert(buf.try_push_n(data.data(), 10) == 10);
+    assert(buf.try_pop_n(out.data(), depth) == 10);
+
+    /* In-place access across the wrap point. */
+    auto reserved = buf.reserve_write(depth);
+    assert(reserved.size() == depth);
+    assert(not reserved.contiguous());
+    uint32_t count = 0;
+    for (auto &elem : reserved.first)
+    {
+        elem = count++;
+    }
+    for (auto &elem : reserved.second)
+    {
+        elem = count++;
+    }
+    assert(buf.commit_write(depth));
+    assert(not buf.commit_write(1));
+
+    auto readable = buf.peek_read();
+    assert(readable.size() == depth);
+    assert(readable.first.front() == 0);
+    assert(readable.second.back() == depth - 1);
+    assert(buf.consume(depth));
+    assert(not buf.consume(1));
+    assert(buf.empty());
+}
+
+void test_threads(void)
+{
+    static constexpr uint32_t total = 1000000;
+
+    Buffer buf;
+
+    std::thread producer([&buf]() {
+        std::array<uint32_t, 7> chunk;
+        uint32_t next = 0;
+        while (next < total)
+        {
+            std::size_t count =
+                std::min<std::size_t>(chunk.size(), total - next);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                chunk[i] = next + i;
+            }
+            buf.push_n_blocking(chunk.data(), count);
+            next += count;
+        }
+    });
+
+    std::array<uint32_t, 64> chunk;
+    uint32_t expected = 0;
+    while (expected < total)
+    {
+        std::size_t count = buf.try_pop_n(chunk);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            assert(chunk[i] == expected);
+            expected++;
+        }
+        if (not count)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    assert(buf.empty());
+}
+
+void test_overwrite(void)
+{
+    using Lossy =
+        SpscBuffer<8, uint32_t, sizeof(uint32_t), ArrayStorage, true>;
+
+    {
+        Lossy buf;
+
+        /* Writes always succeed, the newest data wins. */
+        for (uint32_t i = 0; i < 20; i++)
+        {
+            assert(buf.push(i));
+        }
+        assert(buf.full());
+
+        std::array<uint32_t, 8> vals;
+        assert(buf.pop(vals));
+        for (uint32_t i = 0; i < vals.size(); i++)
+        {
+            assert(vals[i] == 12 + i);
+        }
+        assert(buf.evicted() == 12);
+        assert(buf.empty());
+
+        /* Writes larger than the buffer are still dropped. */
+        std::array<uint32_t, 9> large = {};
+        assert(not buf.push(large, true));
+        assert(buf.write_dropped() == large.size());
+    }
+
+    static constexpr uint32_t total = 200000;
+
+    Lossy buf;
+
+    /* A slow consumer never stalls the producer. */
+    std::thread producer([&buf]() {
+        std::array<uint32_t, 3> chunk;
+        for (uint32_t next = 0; next < total; next += chunk.size())
+        {
+            for (std::size_t i = 0; i < chunk.size(); i++)
+            {
+                chunk[i] = std::min<uint32_t>(next + i, total - 1);
+            }
+            assert(buf.push(chunk));
+        }
+    });
+
+    std::array<uint32_t, 5> chunk;
+    uint64_t popped = 0;
+    uint32_t last = 0;
+    bool first = true;
+    while (first or last != total - 1)
+    {
+        std::size_t count = buf.try_pop_n(chunk);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            /* In order (with gaps), never torn or repeated. */
+            assert(first or chunk[i] > last or chunk[i] == total - 1);
+            first = false;
+            last = chunk[i];
+        }
+        popped += count;
+        std::this_thread::yield();
+    }
+
+    producer.join();
+    uint64_t written = (total + 2) / 3 * 3;
+    assert(popped + buf.evicted() + buf.data_available() == written);
+}
+
+void test_overwrite_lapping(void)
+{
+    using Small =
+        SpscBuffer<4, uint32_t, sizeof(uint32_t), ArrayStorage, true>;
+    static constexpr uint32_t total = 1000000;
+
+    Small buf;
+    std::atomic<bool> done = false;
+
+    std::thread producer([&buf, &done]() {
+        for (uint32_t i = 1; i <= total; i++)
+        {
+            assert(buf.push(i));
+        }
+        done = true;
+    });
+
+    /*
+     * Let the producer lap the reader many times between pops. Slots that
+     * were claimed but not yet published (or never written) would show up
+     * as older values.
+     */
+    std::array<uint32_t, 3> chunk;
+    uint64_t popped = 0;
+    uint32_t last = 0;
+    while (not done or not buf.empty())
+    {
+        std::size_t count = buf.try_pop_n(chunk);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            assert(chunk[i] > last);
+            last = chunk[i];
+        }
+        popped += count;
+
+        for (int i = 0; i < 10; i++)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    assert(last == total);
+    assert(popped + buf.evicted() == total);
+}
+
+int main(void)
+{
+    Buffer buf;
+    test_basic(buf);
+    test_threads();
+    test_overwrite();
+    test_overwrite_lapping();
+    return 0;
+}
@@ -0,0 +1,175 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+/* toolchain */
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <thread>
+
+/* internal */
+#include "buffer/SpscMessageBuffer.h"
+#include "generated/structs/BufferState.h"
+
+using namespace Coral;
+
+using Buffer = SpscMessageBuffer<32, char>;
+
+static std::string text(const RingSegments<const char> &message)
+{
+    std::string result(message.size(), '\0');
+    message.copy_to(result.data(), 0, result.size());
+    return result;
+}
+
+void test_basic(void)
+{
+    Buffer buf;
+    static_assert(buf.max_header == 1);
+    RingSegments<const char> first, second, message;
+
+    assert(buf.empty());
+    assert(not buf.claim(message));
+
+    assert(buf.put_message("abc", 3));
+    {
+        auto ctx = buf.context();
+        ctx.write_n("hello", 5);
+    }
+    assert(buf.data_available() == 4 + 6);
+
+    /* Claimed messages stay in place while the producer appends. */
+    assert(buf.claim(first));
+    assert(buf.claim(second));
+    assert(buf.claimed() == 2);
+    assert(not buf.claim(message));
+    {
+        auto ctx = buf.context();
+        assert(ctx.remaining() == 32 - 10 - 1);
+        ctx.write_n("0123456789", 10);
+        ctx.log("%s", "abcdefghij");
+    }
+    assert(text(first) == "abc");
+    assert(text(second) == "hello");
+
+    /* Messages that don't fit are rejected (leaving the rest). */
+    {
+        auto ctx = buf.context();
+        assert(ctx.remaining() == 0);
+        ctx.write<std::endian::native>('x');
+        assert(ctx.overflowed());
+    }
+    assert(buf.rejected() == 1);
+    assert(not buf.put_message("x", 1));
+
+    /* Releasing frees space (and the next header is at the end). */
+    assert(not buf.release(3));
+    assert(buf.release());
+    assert(buf.claimed() == 1);
+    assert(buf.put_message("xyz", 3));
+    assert(buf.release());
+    assert(buf.claim(message));
+    assert(text(message) == "0123456789abcdefghij");
+    assert(buf.claim(message));
+    assert(text(message) == "xyz");
+    assert(buf.release(2));
+    assert(buf.empty());
+
+    /* Aborted messages are never published. */
+    {
+        auto ctx = buf.context();
+        ctx.write_n("abc", 3);
+        ctx.abort();
+    }
+    assert(buf.rejected() == 2);
+    assert(not buf.claim(message));
+
+    /* Structs, copied out. */
+    BufferState state = {};
+    state.write_cursor = 256;
+    state.read_count = 3;
+    {
+        auto ctx = buf.context();
+        ctx.point<std::endian::little>(&state);
+    }
+
+    std::array<char, 32> out;
+    std::size_t len = 0;
+
+    /* Not while a message is claimed (it would release the wrong one). */
+    assert(buf.claim(message));
+    assert(not buf.get_message(out.data(), len));
+    assert(buf.claimed() == 1);
+    assert(text(message).size() == sizeof(BufferState::id) +
+                                       BufferState::size);
+    assert(buf.release());
+    {
+        auto ctx = buf.context();
+        ctx.point<std::endian::little>(&state);
+    }
+
+    assert(buf.get_message(out.data(), len));
+    assert(len == sizeof(BufferState::id) + BufferState::size);
+    assert(buf.empty());
+
+    std::remove_const_t<decltype(BufferState::id)> id;
+    std::memcpy(&id, out.data(), sizeof(id));
+    assert(handle_endian<std::endian::little>(id) == BufferState::id);
+
+    state = {};
+    state.decode<std::endian::little>(
+        reinterpret_cast<const BufferState::Buffer *>(out.data() +
+                                                      sizeof(id)));
+    assert(state.write_cursor == 256);
+    assert(state.read_count == 3);
+}
+
+void test_threads(void)
+{
+    static constexpr uint32_t count = 100000;
+
+    SpscMessageBuffer<256, uint8_t> buf;
+
+    /* Messages of varying length, each filled with its sequence number. */
+    std::thread producer([&buf]() {
+        std::array<uint8_t, 64> data;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            std::size_t len = i % data.size() + 1;
+            data.fill(static_cast<uint8_t>(i));
+
+            buf.wait_for_space(len);
+            auto ctx = buf.context();
+            ctx.write_n(data.data(), len);
+        }
+    });
+
+    /* Hold a few messages at a time while the producer keeps writing. */
+    RingSegments<const uint8_t> message;
+    for (uint32_t i = 0; i < count;)
+    {
+        buf.wait_for_message();
+        while (buf.claimed() < 3 and ToBool(buf.claim(message)))
+        {
+            assert(message.size() == i % 64 + 1);
+            assert(message.first[0] == static_cast<uint8_t>(i));
+            assert(message.find(static_cast<uint8_t>(i + 1)) ==
+                   message.size());
+            i++;
+        }
+        assert(buf.release(buf.claimed()));
+    }
+
+    producer.join();
+    assert(buf.rejected() == 0);
+    assert(buf.empty());
+}
+
+int main(void)
+{
+    test_basic();
+    test_threads();
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * \file
+ * \brief Statically allocated (in-object) circular-buffer storage.
+ */
+#pragma once
+
+/* toolchain */
+#include <array>
+#include <cstdint>
+
+namespace Coral
+{
+
+/**
+ * Circular-buffer storage backed by an in-object array. The ring wraps at the
+ * end of the array, so accesses spanning the wrap point must be split.
+ *
+ * \tparam depth     The number of elements stored.
+ * \tparam element_t The kind of element stored.
+ * \tparam alignment Alignment of the first element.
+ */
+template <std::size_t depth, typename element_t, std::size_t alignment>
+class ArrayStorage
+{
+  public:
+    /* Whether or not any window of up to depth elements is contiguous. */
+    static constexpr bool mirrored = false;
+
+    ArrayStorage() : elements()
+    {
+    }
+
+    inline element_t *data(void)
+    {
+        return elements.data();
+    }
+
+    inline element_t &operator[](std::size_t index)
+    {
+        return elements[index];
+    }
+
+  protected:
+    alignas(alignment) std::array<element_t, depth> elements;
+};
+
+}; // namespace Coral
@@ -0,0 +1,694 @@
+/**
+ * \file
+ * \brief A lock-free, single-writer multiple-reader broadcast buffer.
+ */
+#pragma once
+
+/* toolchain */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+/* internal */
+#include "../Waiter.h"
+#include "../cache.h"
+#include "ArrayStorage.h"
+#include "PcBufferReader.h"
+#include "PcBufferWriter.h"
+#include "RingSegments.h"
+
+namespace Coral
+{
+
+/**
+ * A ring that one writer thread fans out to several reader threads, each
+ * of which sees every element written while it's attached. Elements are
+ * stored once, however many readers there are, and space is reclaimed once
+ * the slowest reader has read it.
+ *
+ * The writer owns a free-running write cursor and each reader (one of a
+ * fixed number of reader slots) owns its own read cursor, all on separate
+ * cache lines. The writer keeps a cached copy of the slowest reader's
+ * cursor, only rescanning the readers when the cached value suggests the
+ * buffer is full.
+ *
+ * Readers attach (and detach) at any time, from any thread. An attaching
+ * reader is admitted at the writer's cursor on the writer's next write, so
+ * it sees everything written from then on.
+ *
+ * With the drop-lagging policy the writer never waits on a reader that's
+ * idle: a reader that's too far behind for a write to fit is cut loose
+ * (see \ref Reader::lagged) rather than stalling the writer and every other
+ * reader. Readers then mark themselves busy while copying (so they can't be
+ * overwritten mid-read), and zero-copy reads are unavailable.
+ *
+ * \tparam depth        The number of elements the buffer holds.
+ * \tparam element_t    The kind of element the buffer stores.
+ * \tparam readers      The number of reader slots.
+ * \tparam alignment    Alignment of the underlying storage.
+ * \tparam Storage      Storage backend (see \ref ArrayStorage).
+ * \tparam drop_lagging Whether the writer drops readers that lag behind.
+ */
+template <std::size_t depth, typename element_t = std::byte,
+          std::size_t readers = 4, std::size_t alignment = sizeof(element_t),
+          template <std::size_t, typename, std::size_t> class Storage =
+              ArrayStorage,
+          bool drop_lagging = false>
+class BroadcastBuffer
+    : public PcBufferWriter<BroadcastBuffer<depth, element_t, readers,
+                                            alignment, Storage, drop_lagging>,
+                            element_t>
+{
+    static_assert(depth > 0);
+    static_assert(readers > 0);
+
+  public:
+    static constexpr std::size_t Depth = depth;
+    static constexpr std::size_t Readers = readers;
+
+    static constexpr bool Mirrored =
+        Storage<depth, element_t, alignment>::mirrored;
+
+    enum class ReaderState : uint32_t
+    {
+        detached,
+        attaching, /* waiting to be admitted by the writer */
+        active,
+        reading, /* copying out (drop-lagging policy only) */
+        lagged,  /* dropped by the writer (drop-lagging policy only) */
+    };
+
+    /**
+     * A reader slot, i.e. one consumer of the broadcast (with the usual
+     * reader interfaces). Obtained with \ref BroadcastBuffer::attach and
+     * only to be used from one thread at a time.
+     */
+    class alignas(cache_line_size) Reader
+        : public PcBufferReader<Reader, element_t>
+    {
+      public:
+        Reader() : owner(nullptr), state(ReaderState::detached), position(0)
+        {
+        }
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        /* Whether or not the writer has dropped this reader for lagging. */
+        inline bool lagged(void)
+        {
+            return state.load(std::memory_order_acquire) ==
+                   ReaderState::lagged;
+        }
+
+        /* Data available to this reader (a snapshot). */
+        inline std::size_t data_available(void)
+        {
+            return admitted() ? readable(depth) : 0;
+        }
+
+        inline bool empty(void)
+        {
+            return data_available() == 0;
+        }
+
+        /* Give up the slot (call from the reader's own thread). */
+        void detach(void)
+        {
+            if (state.exchange(ReaderState::detached,
+                               std::memory_order_acq_rel) ==
+                ReaderState::attaching)
+            {
+                owner->attaching.fetch_sub(1, std::memory_order_relaxed);
+            }
+            owner->space_ready.notify();
+        }
+
+        /**
+         * Re-attach a lagged reader, skipping whatever it missed (it's
+         * admitted at the writer's cursor on the next write).
+         */
+        Result resync(void)
+        {
+            auto expected = ReaderState::lagged;
+            bool result = state.compare_exchange_strong(
+                expected, ReaderState::attaching, std::memory_order_acq_rel);
+
+            if (result)
+            {
+                owner->attaching.fetch_add(1, std::memory_order_release);
+            }
+
+            return ToResult(result);
+        }
+
+        Result pop_impl(element_t &elem)
+        {
+            return pop_n_impl(&elem, 1);
+        }
+
+        Result pop_n_impl(element_t *elem_array, std::size_t count)
+        {
+            bool result = false;
+
+            if (pin())
+            {
+                result = readable(count) >= count;
+
+                if (result)
+                {
+                    auto at = position.load(std::memory_order_relaxed);
+                    owner->copy_out(at, elem_array, count);
+                    position.store(at + count, std::memory_order_release);
+                }
+
+                unpin();
+            }
+
+            if (result)
+            {
+                owner->space_ready.notify();
+            }
+
+            return ToResult(result);
+        }
+
+        std::size_t try_pop_n_impl(element_t *elem_array, std::size_t count)
+        {
+            std::size_t popped = 0;
+
+            if (pin())
+            {
+                popped = std::min(count, readable(count));
+
+                if (popped)
+                {
+                    auto at = position.load(std::memory_order_relaxed);
+                    owner->copy_out(at, elem_array, popped);
+                    position.store(at + popped, std::memory_order_release);
+                }
+
+                unpin();
+            }
+
+            if (popped)
+            {
+                owner->space_ready.notify();
+            }
+
+            return popped;
+        }
+
+        std::size_t pop_all_impl(element_t *elem_array = nullptr)
+        {
+            return try_pop_n_impl(elem_array, depth);
+        }
+
+        /* Blocking reads resynchronize (skip ahead) if the reader lags. */
+        void pop_blocking_impl(element_t &elem)
+        {
+            while (not ToBool(pop_impl(elem)))
+            {
+                resync();
+                wait_for_data();
+            }
+        }
+
+        void pop_n_blocking_impl(element_t *elem_array, std::size_t count)
+        {
+            std::size_t popped;
+            while (count)
+            {
+                popped = try_pop_n_impl(elem_array, count);
+                if (popped)
+                {
+                    if (elem_array)
+                    {
+                        elem_array += popped;
+                    }
+                    count -= popped;
+                }
+                else
+                {
+                    resync();
+                    wait_for_data();
+                }
+            }
+        }
+
+        /**
+         * Block until at least \p count elements can be read (at most the
+         * buffer depth), this reader lags or \p timeout elapses. Returns
+         * whether or not enough data is available.
+         */
+        bool wait_for_data(std::size_t count = 1,
+                           std::chrono::nanoseconds timeout = Waiter::forever)
+        {
+            count = std::min(count, depth);
+            owner->data_ready.wait(
+                [this, count]() {
+                    return data_available() >= count or lagged();
+                },
+                timeout);
+
+            return data_available() >= count;
+        }
+
+        RingSegments<const element_t> peek_read(std::size_t count = depth)
+            requires(not drop_lagging)
+        {
+            if (not admitted())
+            {
+                return {};
+            }
+
+            return owner->template segments<const element_t>(
+                position.load(std::memory_order_relaxed),
+                std::min(count, readable(count)));
+        }
+
+        Result consume(std::size_t count)
+            requires(not drop_lagging)
+        {
+            bool result = admitted() and readable(count) >= count;
+
+            if (result)
+            {
+                position.fetch_add(count, std::memory_order_release);
+                owner->space_ready.notify();
+            }
+
+            return ToResult(result);
+        }
+
+      protected:
+        friend BroadcastBuffer;
+
+        BroadcastBuffer *owner;
+
+        /* Written by this reader, and by the writer (see above). */
+        std::atomic<ReaderState> state;
+
+        /* The read cursor (set by the writer on admission). */
+        std::atomic<uint64_t> position;
+
+        /* The last observed write cursor. */
+        uint64_t cached = 0;
+
+        inline bool admitted(void)
+        {
+            auto current = state.load(std::memory_order_acquire);
+            return current == ReaderState::active or
+                   current == ReaderState::reading;
+        }
+
+        /* Start reading (keeping the writer from dropping this reader). */
+        inline bool pin(void)
+        {
+            if constexpr (drop_lagging)
+            {
+                auto expected = ReaderState::active;
+                return state.compare_exchange_strong(
+                    expected, ReaderState::reading, std::memory_order_acquire,
+                    std::memory_order_relaxed);
+            }
+            else
+            {
+                return state.load(std::memory_order_acquire) ==
+                       ReaderState::active;
+            }
+        }
+
+        inline void unpin(void)
+        {
+            if constexpr (drop_lagging)
+            {
+                state.store(ReaderState::active, std::memory_order_release);
+            }
+        }
+
+        /* Data available, refreshing the write cursor only if \p wanted
+         * elements don't appear to be present. */
+        inline std::size_t readable(std::size_t wanted)
+        {
+            auto at = position.load(std::memory_order_relaxed);
+            std::size_t data = cached - at;
+
+            if (data < wanted)
+            {
+                cached = owner->writer.position.load(
+                    std::memory_order_acquire);
+                data = cached - at;
+            }
+
+            return data;
+        }
+    };
+
+    BroadcastBuffer()
+        : writer(), attaching(0), data_ready(), space_ready(), buffer(),
+          slots()
+    {
+        for (auto &slot : slots)
+        {
+            slot.owner = this;
+        }
+    }
+
+    BroadcastBuffer(const BroadcastBuffer &) = delete;
+    BroadcastBuffer &operator=(const BroadcastBuffer &) = delete;
+
+    /**
+     * Claim a reader slot (from any thread).
+     *
+     * \return A reader, or nullptr if every slot is taken.
+     */
+    Reader *attach(void)
+    {
+        for (auto &slot : slots)
+        {
+            auto expected = ReaderState::detached;
+            if (slot.state.compare_exchange_strong(expected,
+                                                   ReaderState::attaching,
+                                                   std::memory_order_acq_rel))
+            {
+                attaching.fetch_add(1, std::memory_order_release);
+                return &slot;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /*
+     * Writer-side queries and statistics.
+     */
+
+    inline std::size_t space_available(void)
+    {
+        return writable(depth);
+    }
+
+    inline uint64_t write_dropped(void)
+    {
+        return writer.dropped;
+    }
+
+    /* How many times a reader was dropped for lagging. */
+    inline uint64_t readers_dropped(void)
+    {
+        return writer.lagged;
+    }
+
+    inline const element_t *head(void)
+    {
+        return buffer.data();
+    }
+
+    /*
+     * Writer interfaces.
+     */
+
+    Result push_impl(const element_t elem, bool drop = false)
+    {
+        return push_n_impl(&elem, 1, drop);
+    }
+
+    Result push_n_impl(const element_t *elem_array, std::size_t count,
+                       bool drop = false)
+    {
+        auto position = admit();
+        bool result = count <= depth and writable(count) >= count;
+
+        if (result)
+        {
+            copy_in(position, elem_array, count);
+            writer.position.store(position + count,
+                                  std::memory_order_release);
+            data_ready.notify();
+        }
+        else if (drop)
+        {
+            writer.dropped += count;
+        }
+
+        return ToResult(result);
+    }
+
+    std::size_t try_push_n_impl(const element_t *elem_array, std::size_t count)
+    {
+        auto position = admit();
+        count = std::min(count, writable(count));
+
+        if (count)
+        {
+            copy_in(position, elem_array, count);
+            writer.position.store(position + count,
+                                  std::memory_order_release);
+            data_ready.notify();
+        }
+
+        return count;
+    }
+
+    void push_blocking_impl(const element_t elem)
+    {
+        while (not ToBool(push_impl(elem)))
+        {
+            wait_for_space();
+        }
+    }
+
+    void push_n_blocking_impl(const element_t *elem_array, std::size_t count)
+    {
+        std::size_t pushed;
+        while (count)
+        {
+            pushed = try_push_n_impl(elem_array, count);
+            if (pushed)
+            {
+                if (elem_array)
+                {
+                    elem_array += pushed;
+                }
+                count -= pushed;
+            }
+            else
+            {
+                wait_for_space();
+            }
+        }
+    }
+
+    /**
+     * Block until at least \p count elements can be written (at most the
+     * buffer depth) or \p timeout elapses. Returns whether or not there's
+     * enough space.
+     */
+    bool wait_for_space(std::size_t count = 1,
+                        std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        count = std::min(count, depth);
+        return space_ready.wait(
+            [this, count]() { return writable(count) >= count; }, timeout);
+    }
+
+    RingSegments<element_t> reserve_write(std::size_t count = depth)
+    {
+        return segments<element_t>(admit(),
+                                   std::min(count, writable(count)));
+    }
+
+    Result commit_write(std::size_t count)
+    {
+        bool result = writable(count) >= count;
+
+        if (result)
+        {
+            writer.position.fetch_add(count, std::memory_order_release);
+            data_ready.notify();
+        }
+
+        return ToResult(result);
+    }
+
+  protected:
+    /*
+     * Writer-owned state: the write cursor, the last observed slowest read
+     * cursor and statistics.
+     */
+    struct alignas(cache_line_size) Writer
+    {
+        std::atomic<uint64_t> position = 0;
+        uint64_t slowest = 0;
+        uint64_t dropped = 0;
+        uint64_t lagged = 0;
+    };
+
+    Writer writer;
+
+    /* Readers waiting to be admitted (rarely written). */
+    alignas(cache_line_size) std::atomic<uint32_t> attaching;
+
+    /* Waited on by the readers and writer respectively. */
+    alignas(cache_line_size) Waiter data_ready;
+    Waiter space_ready;
+
+    alignas(cache_line_size) Storage<depth, element_t, alignment> buffer;
+
+    std::array<Reader, readers> slots;
+
+    /*
+     * Admit any attaching readers at the write cursor (before writing
+     * anything they should see). Returns the write cursor.
+     */
+    inline uint64_t admit(void)
+    {
+        auto position = writer.position.load(std::memory_order_relaxed);
+
+        if (attaching.load(std::memory_order_relaxed)) [[unlikely]]
+        {
+            for (auto &slot : slots)
+            {
+                if (slot.state.load(std::memory_order_acquire) ==
+                    ReaderState::attaching)
+                {
+                    /* The reader may detach meanwhile, but not re-admit. */
+                    slot.position.store(position, std::memory_order_relaxed);
+                    slot.cached = position;
+
+                    auto expected = ReaderState::attaching;
+                    if (slot.state.compare_exchange_strong(
+                            expected, ReaderState::active,
+                            std::memory_order_release,
+                            std::memory_order_relaxed))
+                    {
+                        attaching.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        return position;
+    }
+
+    /* Space available to the writer, rescanning the readers only if
+     * \p wanted elements don't appear to fit. */
+    inline std::size_t writable(std::size_t wanted)
+    {
+        auto position = writer.position.load(std::memory_order_relaxed);
+        std::size_t space = depth - (position - writer.slowest);
+
+        if (space < wanted)
+        {
+            writer.slowest = slowest(position, std::min(wanted, depth));
+            space = depth - (position - writer.slowest);
+        }
+
+        return space;
+    }
+
+    /*
+     * The slowest admitted reader's cursor (or the write cursor, if there
+     * are no readers). With the drop-lagging policy, idle readers that keep
+     * \p wanted elements from fitting are dropped instead.
+     */
+    uint64_t slowest(uint64_t position, std::size_t wanted)
+    {
+        uint64_t result = position;
+
+        for (auto &slot : slots)
+        {
+            auto current = slot.state.load(std::memory_order_acquire);
+            if (current != ReaderState::active and
+                current != ReaderState::reading)
+            {
+                continue;
+            }
+
+            auto at = slot.position.load(std::memory_order_acquire);
+
+            if constexpr (drop_lagging)
+            {
+                /* A reader that's mid-copy has to be waited on. */
+                auto expected = ReaderState::active;
+                if (position + wanted - at > depth and
+                    slot.state.compare_exchange_strong(
+                        expected, ReaderState::lagged,
+                        std::memory_order_acq_rel))
+                {
+                    writer.lagged++;
+
+                    /* Wake it up (if it's waiting) to notice. */
+                    data_ready.notify();
+                    continue;
+                }
+            }
+
+            result = std::min(result, at);
+        }
+
+        return result;
+    }
+
+    static inline std::size_t index(uint64_t position)
+    {
+        return position % depth;
+    }
+
+    static constexpr std::size_t contiguous(std::size_t idx)
+    {
+        if constexpr (Mirrored)
+        {
+            (void)idx;
+            return depth;
+        }
+        else
+        {
+            return depth - idx;
+        }
+    }
+
+    template <typename T>
+    inline RingSegments<T> segments(uint64_t position, std::size_t count)
+    {
+        std::size_t idx = index(position);
+        std::size_t first = std::min(contiguous(idx), count);
+        T *base = buffer.data();
+
+        return {std::span<T>(&base[idx], first),
+                std::span<T>(base, count - first)};
+    }
+
+    inline void copy_in(uint64_t position, const element_t *elem_array,
+                        std::size_t count)
+    {
+        if (elem_array)
+        {
+            auto region = segments<element_t>(position, count);
+            std::memcpy(region.first.data(), elem_array,
+                        region.first.size_bytes());
+            std::memcpy(region.second.data(),
+                        elem_array + region.first.size(),
+                        region.second.size_bytes());
+        }
+    }
+
+    inline void copy_out(uint64_t position, element_t *elem_array,
+                         std::size_t count)
+    {
+        if (elem_array)
+        {
+            auto region = segments<const element_t>(position, count);
+            std::memcpy(elem_array, region.first.data(),
+                        region.first.size_bytes());
+            std::memcpy(elem_array + region.first.size(),
+                        region.second.data(), region.second.size_bytes());
+        }
+    }
+};
+
+}; // namespace Coral
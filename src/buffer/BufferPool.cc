@@ -0,0 +1,277 @@
+/* toolchain */
+#include <algorithm>
+
+/* internal */
+#include "../Locks.h"
+#include "BufferPool.h"
+
+namespace Coral
+{
+
+/* Round up to a whole number of cache lines. */
+static std::size_t cache_lines(std::size_t size)
+{
+    return (std::max<std::size_t>(size, 1) + cache_line_size - 1) &
+           ~(cache_line_size - 1);
+}
+
+static inline uint64_t pack_head(uint64_t tag, uint32_t index)
+{
+    return (tag << 32) | index;
+}
+
+BufferPool::BufferPool(std::size_t _slab_size, std::size_t _slab_count,
+                       std::pmr::memory_resource *_upstream)
+    : stride(cache_lines(_slab_size)), count(_slab_count),
+      upstream(_upstream),
+      slabs(static_cast<std::byte *>(
+          upstream->allocate(stride * count, cache_line_size))),
+      next(new std::atomic<uint32_t>[count]), head(pack_head(0, none)),
+      caches(), drawn(0), high_watermark(0), shared_acquires(),
+      shared_releases(), exhausted(), overflow()
+{
+    assert(count > 0 and count < none);
+
+    /* Chain every slab onto the free list (lowest index first). */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        next[i].store(i + 1 < count ? i + 1 : none,
+                      std::memory_order_relaxed);
+    }
+    head.store(pack_head(0, 0), std::memory_order_release);
+}
+
+BufferPool::~BufferPool()
+{
+    assert(stats().in_use == 0);
+    upstream->deallocate(slabs, stride * count, cache_line_size);
+}
+
+uint32_t BufferPool::pop_shared(void)
+{
+    uint64_t current = head.load(std::memory_order_acquire);
+    uint32_t index;
+
+    do
+    {
+        index = static_cast<uint32_t>(current);
+        if (index == none)
+        {
+            break;
+        }
+    } while (not head.compare_exchange_weak(
+        current,
+        pack_head((current >> 32) + 1,
+                  next[index].load(std::memory_order_relaxed)),
+        std::memory_order_acquire, std::memory_order_acquire));
+
+    if (index != none)
+    {
+        std::size_t used = drawn.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::size_t peak = high_watermark.load(std::memory_order_relaxed);
+        while (used > peak and not high_watermark.compare_exchange_weak(
+                                   peak, used, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    return index;
+}
+
+void BufferPool::push_shared(uint32_t index)
+{
+    drawn.fetch_sub(1, std::memory_order_relaxed);
+
+    uint64_t current = head.load(std::memory_order_relaxed);
+
+    do
+    {
+        next[index].store(static_cast<uint32_t>(current),
+                          std::memory_order_relaxed);
+    } while (not head.compare_exchange_weak(
+        current, pack_head((current >> 32) + 1, index),
+        std::memory_order_release, std::memory_order_relaxed));
+}
+
+uint32_t BufferPool::steal(void)
+{
+    for (auto &cache : caches)
+    {
+        /*
+         * Slots are only held for a few instructions, and this is the slow
+         * path anyway, so wait rather than miss a cached slab.
+         */
+        uint32_t spins = 0;
+        while (cache.busy.test_and_set(std::memory_order_acquire))
+        {
+            spin_wait(spins);
+        }
+
+        uint32_t index = none;
+        if (cache.depth)
+        {
+            index = cache.slabs[--cache.depth];
+        }
+        cache.busy.clear(std::memory_order_release);
+
+        if (index != none)
+        {
+            return index;
+        }
+    }
+
+    return none;
+}
+
+BufferPool::ThreadCache &BufferPool::local_cache(void)
+{
+    /* Spread threads across cache slots in the order they first show up. */
+    static std::atomic<std::size_t> threads = 0;
+    static thread_local const std::size_t ordinal =
+        threads.fetch_add(1, std::memory_order_relaxed);
+
+    return caches[ordinal % cache_slots];
+}
+
+void *BufferPool::acquire(void)
+{
+    uint32_t index = none;
+
+    /*
+     * Try this thread's cache first. It's only ever contended by threads
+     * sharing the slot (or stealing), so give up rather than wait.
+     */
+    ThreadCache &cache = local_cache();
+    if (not cache.busy.test_and_set(std::memory_order_acquire))
+    {
+        if (cache.depth)
+        {
+            index = cache.slabs[--cache.depth];
+            cache.cache_hits++;
+        }
+        else
+        {
+            index = pop_shared();
+        }
+
+        if (index != none)
+        {
+            cache.acquires++;
+        }
+        cache.busy.clear(std::memory_order_release);
+    }
+    else if ((index = pop_shared()) != none)
+    {
+        shared_acquires.add_concurrent();
+    }
+
+    if (index == none)
+    {
+        if ((index = steal()) == none)
+        {
+            exhausted.add_concurrent();
+            return nullptr;
+        }
+        shared_acquires.add_concurrent();
+    }
+
+    return slab(index);
+}
+
+void BufferPool::release(void *ptr)
+{
+    assert(owns(ptr));
+
+    auto index = static_cast<uint32_t>(
+        (static_cast<std::byte *>(ptr) - slabs) / stride);
+    assert(slab(index) == ptr);
+
+    /* Keep the slab local if there's room, otherwise share it. */
+    ThreadCache &cache = local_cache();
+    if (not cache.busy.test_and_set(std::memory_order_acquire))
+    {
+        if (cache.depth < cache_depth)
+        {
+            cache.slabs[cache.depth++] = index;
+        }
+        else
+        {
+            push_shared(index);
+        }
+
+        cache.releases++;
+        cache.busy.clear(std::memory_order_release);
+    }
+    else
+    {
+        push_shared(index);
+        shared_releases.add_concurrent();
+    }
+}
+
+BufferPoolStats BufferPool::stats(void) const
+{
+    BufferPoolStats result = {};
+
+    result.slab_size = stride;
+    result.slab_count = count;
+
+    result.acquires = shared_acquires;
+    result.releases = shared_releases;
+    for (const auto &cache : caches)
+    {
+        result.acquires += cache.acquires;
+        result.releases += cache.releases;
+        result.cache_hits += cache.cache_hits;
+    }
+
+    /* Counters are read one at a time, so clamp any transient skew. */
+    result.in_use = result.acquires > result.releases
+                        ? std::min<uint64_t>(
+                              result.acquires - result.releases, count)
+                        : 0;
+    result.high_watermark = high_watermark.load(std::memory_order_relaxed);
+    result.exhausted = exhausted;
+    result.overflow = overflow;
+
+    return result;
+}
+
+void *BufferPool::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    void *result = nullptr;
+
+    if (bytes <= stride and alignment <= cache_line_size)
+    {
+        result = acquire();
+    }
+
+    if (not result)
+    {
+        overflow.add_concurrent();
+        result = upstream->allocate(bytes, alignment);
+    }
+
+    return result;
+}
+
+void BufferPool::do_deallocate(void *ptr, std::size_t bytes,
+                               std::size_t alignment)
+{
+    if (owns(ptr))
+    {
+        release(ptr);
+    }
+    else
+    {
+        upstream->deallocate(ptr, bytes, alignment);
+    }
+}
+
+bool BufferPool::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+}; // namespace Coral
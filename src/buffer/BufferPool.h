@@ -0,0 +1,207 @@
+/**
+ * \file
+ * \brief A pool of fixed-size, cache-line-aligned storage slabs.
+ */
+#pragma once
+
+/* toolchain */
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+/* internal */
+#include "../cache.h"
+#include "PcBufferState.h"
+
+namespace Coral
+{
+
+/* A snapshot of pool occupancy (safe to take from any thread). */
+struct BufferPoolStats
+{
+    std::size_t slab_size;
+    std::size_t slab_count;
+
+    /* Slabs currently handed out. */
+    std::size_t in_use;
+
+    /*
+     * The most slabs ever out of the shared free list at once (handed out
+     * or held in a per-thread cache), i.e. the pool's peak footprint.
+     */
+    std::size_t high_watermark;
+
+    uint64_t acquires;
+    uint64_t releases;
+
+    /* Acquires served from a per-thread cache (no shared-list traffic). */
+    uint64_t cache_hits;
+
+    /* Acquires that failed because every slab was in use. */
+    uint64_t exhausted;
+
+    /* Allocations passed to the upstream resource (too big or exhausted). */
+    uint64_t overflow;
+};
+
+/**
+ * Pre-allocated storage slabs for buffer instances (or their storage), so
+ * that creating and destroying buffers stays off the system allocator.
+ *
+ * Acquire and release are O(1) and never lock: each thread first uses a
+ * small cache of slabs (one of several cache slots, chosen by thread), and
+ * otherwise a shared lock-free free list. Statistics are kept per cache slot
+ * so the fast path costs one uncontended atomic exchange. Slabs are
+ * cache-line aligned and sized so neighbouring slabs never share a line.
+ *
+ * The pool is also a std::pmr::memory_resource, e.g. for the storage of a
+ * \ref DynamicPcBuffer; allocations it can't serve go to an upstream
+ * resource. Slabs must all be released before the pool is destroyed.
+ */
+class BufferPool : public std::pmr::memory_resource
+{
+  public:
+    /* Per-thread cache geometry. */
+    static constexpr std::size_t cache_slots = 8;
+    static constexpr std::size_t cache_depth = 8;
+
+    BufferPool(std::size_t _slab_size, std::size_t _slab_count,
+               std::pmr::memory_resource *_upstream =
+                   std::pmr::get_default_resource());
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    inline std::size_t slab_size(void) const
+    {
+        return stride;
+    }
+
+    inline std::size_t slab_count(void) const
+    {
+        return count;
+    }
+
+    /* Whether or not a pointer is a slab from this pool. */
+    inline bool owns(const void *ptr) const
+    {
+        auto bytes = static_cast<const std::byte *>(ptr);
+        return bytes >= slabs and bytes < slabs + stride * count;
+    }
+
+    /**
+     * Get a slab.
+     *
+     * \return A slab of \ref slab_size bytes, or nullptr if every slab is in
+     *         use.
+     */
+    void *acquire(void);
+
+    /* Return a slab obtained with \ref acquire. */
+    void release(void *slab);
+
+    BufferPoolStats stats(void) const;
+
+    /* Destroys (and releases the slab of) an object created by make. */
+    template <typename T> struct Deleter
+    {
+        BufferPool *pool;
+
+        inline void operator()(T *object) const
+        {
+            object->~T();
+            pool->release(object);
+        }
+    };
+
+    template <typename T> using Handle = std::unique_ptr<T, Deleter<T>>;
+
+    /**
+     * Construct an object (e.g. a buffer) in a slab.
+     *
+     * \return The object, or an empty handle if it doesn't fit a slab or
+     *         every slab is in use.
+     */
+    template <typename T, typename... Args> Handle<T> make(Args &&...args)
+    {
+        static_assert(alignof(T) <= cache_line_size);
+
+        /* An oversized object would overrun into the next slab. */
+        T *object = nullptr;
+        void *storage = sizeof(T) <= slab_size() ? acquire() : nullptr;
+        if (storage)
+        {
+            object = new (storage) T(std::forward<Args>(args)...);
+        }
+
+        return Handle<T>(object, Deleter<T>{this});
+    }
+
+  protected:
+    static constexpr uint32_t none = UINT32_MAX;
+
+    struct alignas(cache_line_size) ThreadCache
+    {
+        std::atomic_flag busy;
+        std::size_t depth = 0;
+        std::array<uint32_t, cache_depth> slabs;
+
+        /* Only updated while holding the slot. */
+        BufferCounter acquires;
+        BufferCounter releases;
+        BufferCounter cache_hits;
+    };
+
+    const std::size_t stride;
+    const std::size_t count;
+    std::pmr::memory_resource *const upstream;
+
+    std::byte *const slabs;
+
+    /* Free list links (by slab index). */
+    std::unique_ptr<std::atomic<uint32_t>[]> next;
+
+    /* Free list head: slab index in the low word, ABA tag in the high. */
+    alignas(cache_line_size) std::atomic<uint64_t> head;
+
+    std::array<ThreadCache, cache_slots> caches;
+
+    /* Slabs out of the shared free list, and the most there ever were. */
+    alignas(cache_line_size) std::atomic<std::size_t> drawn;
+    std::atomic<std::size_t> high_watermark;
+
+    /* Operations that couldn't use a cache slot (slot busy, or stolen). */
+    BufferCounter shared_acquires;
+    BufferCounter shared_releases;
+
+    BufferCounter exhausted;
+    BufferCounter overflow;
+
+    inline std::byte *slab(uint32_t index) const
+    {
+        return slabs + index * stride;
+    }
+
+    /* The free list (tracks footprint, which is updated on this path). */
+    uint32_t pop_shared(void);
+    void push_shared(uint32_t index);
+
+    /* Take a slab from any thread's cache (when the free list is empty). */
+    uint32_t steal(void);
+
+    ThreadCache &local_cache(void);
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *ptr, std::size_t bytes,
+                       std::size_t alignment) override;
+    bool do_is_equal(
+        const std::pmr::memory_resource &other) const noexcept override;
+};
+
+}; // namespace Coral
@@ -12,12 +12,18 @@
 /* internal */
 #include "../generated/ifgen/common.h"
 #include "../generated/structs/BufferState.h"
+#include "ArrayStorage.h"
+#include "RingCursor.h"
+#include "RingSegments.h"
+#include "endian_copy.h"
 
 namespace Coral
 {
 
 template <std::size_t depth, typename element_t = std::byte,
-          std::size_t alignment = sizeof(element_t)>
+          std::size_t alignment = sizeof(element_t),
+          template <std::size_t, typename, std::size_t> class Storage =
+              ArrayStorage>
 class CircularBuffer
 {
     static_assert(depth > 0);
@@ -26,7 +32,12 @@ class CircularBuffer
   public:
     static constexpr std::size_t Depth = depth;
 
-    CircularBuffer() : buffer(), state()
+    /* Whether or not any window of up to depth elements is contiguous. */
+    static constexpr bool Mirrored =
+        Storage<depth, element_t, alignment>::mirrored;
+
+    CircularBuffer()
+        : buffer(), write_cursor(), read_cursor(), writes(0), reads(0)
     {
     }
 
@@ -81,12 +92,94 @@ class CircularBuffer
         elem->template endian<endianness>();
     }
 
+    /**
+     * Write an array of values, converted to \p endianness, in a single pass
+     * (handling wraparound, including a value split across the end of the
+     * buffer). The caller is responsible for there being enough space.
+     *
+     * \param[in] values The values to write.
+     * \return           The number of elements (bytes) written.
+     */
+    template <std::endian endianness, endian_scalar T>
+    inline std::size_t write_array(std::span<const T> values)
+        requires byte_size<element_t>
+    {
+        std::size_t count = values.size_bytes();
+        auto region = reserve_write(count);
+        auto src = reinterpret_cast<const std::byte *>(values.data());
+
+        /* Values that fit before the end of the buffer. */
+        std::size_t whole = region.first.size() / sizeof(T);
+        endian_copy<endianness, T>(region.first.data(), src, whole);
+
+        std::size_t done = whole * sizeof(T);
+        std::size_t split = region.first.size() - done;
+        std::size_t offset = 0;
+
+        /* A value straddling the end of the buffer. */
+        if (split)
+        {
+            std::array<std::byte, sizeof(T)> temp;
+            endian_copy<endianness, T>(temp.data(), src + done, 1);
+            std::memcpy(region.first.data() + done, temp.data(), split);
+            offset = sizeof(T) - split;
+            std::memcpy(region.second.data(), temp.data() + split, offset);
+            done += sizeof(T);
+        }
+
+        endian_copy<endianness, T>(region.second.data() + offset, src + done,
+                                   (count - done) / sizeof(T));
+
+        commit_write(count);
+        return count;
+    }
+
+    /**
+     * Read an array of values, converted from \p endianness, in a single
+     * pass (see \ref write_array). The caller is responsible for there being
+     * enough data.
+     *
+     * \param[out] values The values to read.
+     * \return            The number of elements (bytes) read.
+     */
+    template <std::endian endianness, endian_scalar T>
+    inline std::size_t read_array(std::span<T> values)
+        requires byte_size<element_t>
+    {
+        std::size_t count = values.size_bytes();
+        auto region = peek_read(count);
+        auto dst = reinterpret_cast<std::byte *>(values.data());
+
+        std::size_t whole = region.first.size() / sizeof(T);
+        endian_copy<endianness, T>(dst, region.first.data(), whole);
+
+        std::size_t done = whole * sizeof(T);
+        std::size_t split = region.first.size() - done;
+        std::size_t offset = 0;
+
+        if (split)
+        {
+            std::array<std::byte, sizeof(T)> temp;
+            std::memcpy(temp.data(), region.first.data() + done, split);
+            offset = sizeof(T) - split;
+            std::memcpy(temp.data() + split, region.second.data(), offset);
+            endian_copy<endianness, T>(dst + done, temp.data(), 1);
+            done += sizeof(T);
+        }
+
+        endian_copy<endianness, T>(dst + done, region.second.data() + offset,
+                                   (count - done) / sizeof(T));
+
+        consume(count);
+        return count;
+    }
+
     inline std::size_t write_single(const element_t elem)
     {
         buffer[write_index()] = elem;
-        state.write_cursor++;
+        write_cursor.advance(1);
 
-        state.write_count++;
+        writes++;
         return 1;
     }
 
@@ -103,7 +196,7 @@ class CircularBuffer
              * We can only write from the current index to the end of the
              * underlying, linear buffer.
              */
-            max_contiguous = depth - write_index();
+            max_contiguous = contiguous(write_index());
             to_write = std::min(max_contiguous, count);
 
             /* Copy the bytes (elements -> buffer). */
@@ -115,9 +208,9 @@ class CircularBuffer
             }
 
             count -= to_write;
-            state.write_cursor += to_write;
+            write_cursor.advance(to_write);
 
-            state.write_count += to_write;
+            writes += to_write;
         }
 
         return count;
@@ -131,9 +224,9 @@ class CircularBuffer
     inline void read_single(element_t &elem)
     {
         elem = peek();
-        state.read_cursor++;
+        read_cursor.advance(1);
 
-        state.read_count++;
+        reads++;
     }
 
     inline element_t read_single(void)
@@ -156,7 +249,7 @@ class CircularBuffer
              * We can only read from the current index to the end of the
              * underlying, linear buffer.
              */
-            max_contiguous = depth - read_index();
+            max_contiguous = contiguous(read_index());
             to_read = std::min(max_contiguous, count);
 
             /* Copy the bytes (buffer -> elements). */
@@ -168,12 +261,61 @@ class CircularBuffer
             }
 
             count -= to_read;
-            state.read_cursor += to_read;
+            read_cursor.advance(to_read);
 
-            state.read_count += to_read;
+            reads += to_read;
         }
     }
 
+    /**
+     * Get the region that the next \p count written elements will occupy,
+     * without advancing the write cursor. The caller is responsible for not
+     * overwriting unread data.
+     *
+     * \param[in] count The number of elements to reserve (at most depth).
+     * \return          Up to two spans covering \p count elements.
+     */
+    inline RingSegments<element_t> reserve_write(std::size_t count)
+    {
+        return segments<element_t>(write_index(), count);
+    }
+
+    /**
+     * Advance the write cursor over elements populated in-place (after
+     * \ref reserve_write).
+     *
+     * \param[in] count The number of elements written.
+     */
+    inline void commit_write(std::size_t count)
+    {
+        write_cursor.advance(count);
+        writes += count;
+    }
+
+    /**
+     * Get the region holding the next \p count elements to be read, without
+     * advancing the read cursor.
+     *
+     * \param[in] count The number of elements to view (at most depth).
+     * \return          Up to two spans covering \p count elements.
+     */
+    inline RingSegments<const element_t> peek_read(std::size_t count)
+    {
+        return segments<const element_t>(read_index(), count);
+    }
+
+    /**
+     * Advance the read cursor over elements accessed in-place (after
+     * \ref peek_read).
+     *
+     * \param[in] count The number of elements read.
+     */
+    inline void consume(std::size_t count)
+    {
+        read_cursor.advance(count);
+        reads += count;
+    }
+
     inline void poll_metrics(uint32_t &_read_count, uint32_t &_write_count,
                              bool reset = true)
     {
@@ -183,27 +325,55 @@ class CircularBuffer
 
     inline uint32_t write_count(bool reset = true)
     {
-        auto result = state.write_count;
+        auto result = writes;
         if (reset)
         {
-            state.write_count = 0;
+            writes = 0;
         }
         return result;
     }
 
     inline uint32_t read_count(bool reset = true)
     {
-        auto result = state.read_count;
+        auto result = reads;
         if (reset)
         {
-            state.read_count = 0;
+            reads = 0;
         }
         return result;
     }
 
     inline void reset(void)
     {
-        state = {};
+        write_cursor.reset();
+        read_cursor.reset();
+        writes = 0;
+        reads = 0;
+    }
+
+    /* Total elements written and read since the last reset. */
+    inline uint64_t total_written(void) const
+    {
+        return write_cursor.total();
+    }
+
+    inline uint64_t total_read(void) const
+    {
+        return read_cursor.total();
+    }
+
+    /**
+     * Get a snapshot of buffer state in its (packed, 32-bit) wire format.
+     * Cursors are truncated, only differences between them are meaningful.
+     */
+    inline BufferState snapshot(void) const
+    {
+        BufferState result = {};
+        result.write_cursor = static_cast<uint32_t>(write_cursor.total());
+        result.read_cursor = static_cast<uint32_t>(read_cursor.total());
+        result.read_count = reads;
+        result.write_count = writes;
+        return result;
     }
 
     inline const element_t *head(void)
@@ -212,18 +382,48 @@ class CircularBuffer
     }
 
   protected:
-    alignas(alignment) std::array<element_t, depth> buffer;
+    Storage<depth, element_t, alignment> buffer;
 
-    BufferState state;
+    /* Hot cursor state (see \ref snapshot for the wire format). */
+    RingCursor<depth> write_cursor;
+    RingCursor<depth> read_cursor;
+    uint32_t writes;
+    uint32_t reads;
 
     inline std::size_t write_index(void)
     {
-        return state.write_cursor % depth;
+        return write_cursor.index();
     }
 
     inline std::size_t read_index(void)
     {
-        return state.read_cursor % depth;
+        return read_cursor.index();
+    }
+
+    template <typename T>
+    inline RingSegments<T> segments(std::size_t index, std::size_t count)
+    {
+        assert(count <= depth);
+
+        std::size_t first = std::min(contiguous(index), count);
+        T *base = buffer.data();
+
+        return {std::span<T>(&base[index], first),
+                std::span<T>(base, count - first)};
+    }
+
+    /* The number of elements that can be accessed linearly from an index. */
+    static constexpr std::size_t contiguous(std::size_t index)
+    {
+        if constexpr (Mirrored)
+        {
+            (void)index;
+            return depth;
+        }
+        else
+        {
+            return depth - index;
+        }
     }
 };
 
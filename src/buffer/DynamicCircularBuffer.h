@@ -0,0 +1,188 @@
+/**
+ * \file
+ * \brief A circular buffer with capacity chosen at runtime.
+ */
+#pragma once
+
+/* toolchain */
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+
+/* internal */
+#include "RingCore.h"
+#include "RingSegments.h"
+
+namespace Coral
+{
+
+/**
+ * A circular buffer over caller-supplied storage (a span), or storage
+ * allocated from a memory resource. Provides the same element interface as
+ * \ref CircularBuffer, as a thin typed layer over \ref RingCore.
+ *
+ * \tparam element_t The kind of element the buffer stores.
+ * \tparam alignment Required alignment of the storage.
+ */
+template <typename element_t = std::byte,
+          std::size_t alignment = sizeof(element_t)>
+class DynamicCircularBuffer
+{
+    static_assert(std::is_trivially_copyable_v<element_t>);
+    static_assert(std::has_single_bit(alignment));
+
+  public:
+    static constexpr bool Mirrored = false;
+
+    /* Use (but don't own) existing storage. */
+    DynamicCircularBuffer(std::span<element_t> storage)
+        : core(reinterpret_cast<std::byte *>(storage.data()), storage.size(),
+               sizeof(element_t)),
+          resource(nullptr)
+    {
+        assert(reinterpret_cast<std::uintptr_t>(storage.data()) % alignment ==
+               0);
+    }
+
+    /* Allocate (and own) storage for capacity elements. */
+    DynamicCircularBuffer(std::size_t capacity,
+                          std::pmr::memory_resource *_resource =
+                              std::pmr::get_default_resource())
+        : core(static_cast<std::byte *>(_resource->allocate(
+                   capacity * sizeof(element_t), storage_alignment)),
+               capacity, sizeof(element_t)),
+          resource(_resource)
+    {
+    }
+
+    ~DynamicCircularBuffer()
+    {
+        if (resource)
+        {
+            resource->deallocate(core.at(0), capacity() * sizeof(element_t),
+                                 storage_alignment);
+        }
+    }
+
+    DynamicCircularBuffer(const DynamicCircularBuffer &) = delete;
+    DynamicCircularBuffer &operator=(const DynamicCircularBuffer &) = delete;
+
+    inline std::size_t capacity(void) const
+    {
+        return core.capacity();
+    }
+
+    inline std::size_t write_single(const element_t elem)
+    {
+        *slot(core.write_index()) = elem;
+        core.commit_write(1);
+        return 1;
+    }
+
+    inline std::size_t write_n(const element_t *elem_array, std::size_t count)
+    {
+        core.write(elem_array, count);
+        return count;
+    }
+
+    inline element_t peek(void)
+    {
+        return *slot(core.read_index());
+    }
+
+    inline void read_single(element_t &elem)
+    {
+        elem = peek();
+        core.consume(1);
+    }
+
+    inline element_t read_single(void)
+    {
+        element_t elem;
+        read_single(elem);
+        return elem;
+    }
+
+    inline void read_n(element_t *elem_array, std::size_t count)
+    {
+        core.read(elem_array, count);
+    }
+
+    inline RingSegments<element_t> reserve_write(std::size_t count)
+    {
+        return segments<element_t>(core.write_index(), count);
+    }
+
+    inline void commit_write(std::size_t count)
+    {
+        core.commit_write(count);
+    }
+
+    inline RingSegments<const element_t> peek_read(std::size_t count)
+    {
+        return segments<const element_t>(core.read_index(), count);
+    }
+
+    inline void consume(std::size_t count)
+    {
+        core.consume(count);
+    }
+
+    inline void poll_metrics(uint32_t &_read_count, uint32_t &_write_count,
+                             bool reset = true)
+    {
+        core.poll_metrics(_read_count, _write_count, reset);
+    }
+
+    inline void reset(void)
+    {
+        core.reset();
+    }
+
+    inline uint64_t total_written(void) const
+    {
+        return core.total_written();
+    }
+
+    inline uint64_t total_read(void) const
+    {
+        return core.total_read();
+    }
+
+    inline const element_t *head(void)
+    {
+        return slot(0);
+    }
+
+  protected:
+    static constexpr std::size_t storage_alignment =
+        std::max(alignment, alignof(element_t));
+
+    RingCore core;
+
+    /* Owning memory resource (if storage was allocated). */
+    std::pmr::memory_resource *resource;
+
+    inline element_t *slot(std::size_t index)
+    {
+        return reinterpret_cast<element_t *>(core.at(index));
+    }
+
+    template <typename T>
+    inline RingSegments<T> segments(std::size_t index, std::size_t count)
+    {
+        assert(count <= capacity());
+
+        std::size_t first = std::min(core.contiguous(index), count);
+        T *base = slot(0);
+
+        return {std::span<T>(&base[index], first),
+                std::span<T>(base, count - first)};
+    }
+};
+
+}; // namespace Coral
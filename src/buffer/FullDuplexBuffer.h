@@ -1,34 +1,169 @@
 #pragma once
 
+/* toolchain */
+#include <array>
+#include <cassert>
+#include <span>
+#include <utility>
+
 /* internal */
 #include "PcBuffer.h"
 
 namespace Coral
 {
 
+/* How service_tx shares the link between transmit lanes. */
+enum class TxPolicy
+{
+    /* Always drain the highest-priority (lowest-numbered) lane first. */
+    strict_priority,
+
+    /* Deficit round robin: each lane gets its quantum of elements a turn. */
+    weighted_fair,
+};
+
+/* A snapshot of a transmit lane's statistics. */
+struct TxLaneStats
+{
+    /* The lane's own buffer metrics (queue depth, drops, etc.). */
+    BufferMetrics buffer;
+
+    /* Elements handed to the link. */
+    uint64_t sent;
+
+    /* Calls to the link (contiguous runs of elements). */
+    uint64_t bursts;
+
+    /* Times the link filled up while the lane still had data queued. */
+    uint64_t waited;
+};
+
+/**
+ * A transmit (tx) and receive (rx) buffer pair for a link, serviced through
+ * the implementing class.
+ *
+ * With several transmit lanes, urgent traffic (e.g. control frames) can be
+ * queued on a higher-priority lane instead of behind bulk transfers. The
+ * implementing class then provides the link itself, as
+ * `std::size_t transmit_impl(std::span<const element_t>)` (returning how
+ * many elements the link accepted), and service_tx moves data from the
+ * lanes to the link according to the \ref TxPolicy.
+ *
+ * \tparam T         The implementing class (CRTP).
+ * \tparam tx_depth  The depth of each transmit lane.
+ * \tparam rx_depth  The depth of the receive buffer.
+ * \tparam element_t The kind of element the buffers store.
+ * \tparam alignment Alignment of the underlying storage.
+ * \tparam tx_lanes  The number of transmit lanes (lane 0 is the highest
+ *                   priority, and \ref tx is the lowest).
+ */
 template <class T, size_t tx_depth, size_t rx_depth,
           typename element_t = std::byte,
-          std::size_t alignment = sizeof(element_t)>
+          std::size_t alignment = sizeof(element_t),
+          std::size_t tx_lanes = 1>
 class FullDuplexBuffer
 {
+    static_assert(tx_lanes > 0);
+
   public:
-    using TxBuffer = PcBuffer<tx_depth, element_t, alignment>;
-    using RxBuffer = PcBuffer<rx_depth, element_t, alignment>;
+    static constexpr std::size_t TxLanes = tx_lanes;
+
+    /* Elements a lane may send per turn by default (weighted-fair). */
+    static constexpr std::size_t default_quantum = 64;
+
+    /*
+     * The writing end, serviced (through the implementing class) whenever
+     * data is ready to be written.
+     */
+    class TxBuffer : public PcBufferBase<TxBuffer, tx_depth, element_t,
+                                         alignment>
+    {
+      public:
+        TxBuffer(T *_parent, bool _auto_service)
+            : PcBufferBase<TxBuffer, tx_depth, element_t, alignment>(
+                  _auto_service),
+              parent(_parent), quantum(default_quantum), deficit(0),
+              sent(), bursts(), waited()
+        {
+        }
+
+        inline void service_data_impl(void)
+        {
+            parent->service_tx(this);
+        }
+
+        TxLaneStats stats(void) const
+        {
+            return {this->metrics(), sent, bursts, waited};
+        }
+
+      protected:
+        friend FullDuplexBuffer;
+
+        T *parent;
+
+        /* Deficit round robin state. */
+        std::size_t quantum;
+        std::size_t deficit;
+
+        BufferCounter sent;
+        BufferCounter bursts;
+        BufferCounter waited;
+    };
+
+    /*
+     * The reading end, serviced (through the implementing class) whenever
+     * the read buffer has space.
+     */
+    class RxBuffer : public PcBufferBase<RxBuffer, rx_depth, element_t,
+                                         alignment>
+    {
+      public:
+        RxBuffer(T *_parent, bool _auto_service)
+            : PcBufferBase<RxBuffer, rx_depth, element_t, alignment>(
+                  _auto_service),
+              parent(_parent)
+        {
+        }
+
+        inline void service_space_impl(void)
+        {
+            parent->service_rx(this);
+        }
+
+      protected:
+        T *parent;
+    };
 
     FullDuplexBuffer(bool _auto_service = true)
-        : tx(_auto_service), rx(_auto_service)
+        : lanes(make_lanes(static_cast<T *>(this), _auto_service,
+                           std::make_index_sequence<tx_lanes>{})),
+          tx(lanes.back()), rx(static_cast<T *>(this), _auto_service),
+          policy(TxPolicy::strict_priority), turn(0), visiting(false)
     {
-        /*
-         * Attempt to service the writing end whenever data is ready to be
-         * written.
-         */
-        tx.set_data_available([this](TxBuffer *buf) { service_tx(buf); });
+    }
 
-        /*
-         * Attempt to service the reading end whenever the read buffer has
-         * space.
-         */
-        rx.set_space_available([this](RxBuffer *buf) { service_rx(buf); });
+    /* A transmit lane (0 is the highest priority). */
+    inline TxBuffer &lane(std::size_t index)
+    {
+        return lanes[index];
+    }
+
+    inline void set_tx_policy(TxPolicy _policy)
+    {
+        policy = _policy;
+    }
+
+    /* Set how many elements a lane may send per turn (weighted-fair). */
+    inline void set_quantum(std::size_t index, std::size_t quantum)
+    {
+        assert(quantum > 0);
+        lanes[index].quantum = quantum;
+    }
+
+    inline TxLaneStats lane_stats(std::size_t index) const
+    {
+        return lanes[index].stats();
     }
 
     /*
@@ -43,7 +178,15 @@ class FullDuplexBuffer
 
     inline void service_tx(TxBuffer *buf)
     {
-        static_cast<T *>(this)->service_tx_impl(buf);
+        if constexpr (tx_lanes == 1)
+        {
+            static_cast<T *>(this)->service_tx_impl(buf);
+        }
+        else
+        {
+            (void)buf;
+            drain_tx();
+        }
     }
 
     inline void service_rx(RxBuffer *buf)
@@ -51,8 +194,143 @@ class FullDuplexBuffer
         static_cast<T *>(this)->service_rx_impl(buf);
     }
 
-    TxBuffer tx;
+  protected:
+    std::array<TxBuffer, tx_lanes> lanes;
+
+  public:
+    TxBuffer &tx;
     RxBuffer rx;
+
+  protected:
+    TxPolicy policy;
+
+    /* The lane whose turn it is, and whether it's been credited yet. */
+    std::size_t turn;
+    bool visiting;
+
+    template <std::size_t... index>
+    static std::array<TxBuffer, tx_lanes> make_lanes(
+        T *parent, bool auto_service, std::index_sequence<index...>)
+    {
+        return {{((void)index, TxBuffer(parent, auto_service))...}};
+    }
+
+    /*
+     * Hand (up to \p limit elements of) a lane's next contiguous run to the
+     * link. Returns whether or not the link took all of it.
+     */
+    bool transmit(TxBuffer &lane, std::size_t limit)
+    {
+        auto segment = lane.peek_read(limit).first;
+        std::size_t sent = static_cast<T *>(this)->transmit_impl(
+            std::span<const element_t>(segment));
+
+        assert(sent <= segment.size());
+        if (sent)
+        {
+            lane.consume(sent);
+            lane.sent += sent;
+            lane.bursts++;
+        }
+
+        return sent == segment.size();
+    }
+
+    /* Note which lanes still had data when the link filled up. */
+    void link_full(void)
+    {
+        for (auto &lane : lanes)
+        {
+            if (not lane.empty())
+            {
+                lane.waited++;
+            }
+        }
+    }
+
+    void drain_tx(void)
+    {
+        if (policy == TxPolicy::strict_priority)
+        {
+            drain_strict();
+        }
+        else
+        {
+            drain_fair();
+        }
+    }
+
+    void drain_strict(void)
+    {
+        /* Re-check higher-priority lanes after every run. */
+        for (std::size_t index = 0; index < tx_lanes;)
+        {
+            if (lanes[index].empty())
+            {
+                index++;
+            }
+            else if (transmit(lanes[index], tx_depth))
+            {
+                index = 0;
+            }
+            else
+            {
+                link_full();
+                return;
+            }
+        }
+    }
+
+    void drain_fair(void)
+    {
+        auto pending = [this]() {
+            for (auto &lane : lanes)
+            {
+                if (not lane.empty())
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        /*
+         * Each visit credits a lane its quantum, which it spends (carrying
+         * over what's left while it has data). A visit cut short by the link
+         * resumes on the next drain.
+         */
+        while (pending())
+        {
+            TxBuffer &lane = lanes[turn];
+
+            if (not visiting and not lane.empty())
+            {
+                lane.deficit += lane.quantum;
+                visiting = true;
+            }
+
+            while (visiting and lane.deficit and not lane.empty())
+            {
+                std::size_t before = lane.sent;
+                bool all = transmit(lane, lane.deficit);
+                lane.deficit -= lane.sent - before;
+
+                if (not all)
+                {
+                    link_full();
+                    return;
+                }
+            }
+
+            if (lane.empty())
+            {
+                lane.deficit = 0;
+            }
+
+            visiting = false;
+            turn = (turn + 1) % tx_lanes;
+        }
+    }
 };
 
 } // namespace Coral
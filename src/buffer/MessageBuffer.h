@@ -4,49 +4,139 @@
  */
 #pragma once
 
+/* toolchain */
+#include <algorithm>
+#include <array>
+#include <cstdarg>
+#include <span>
+#include <type_traits>
+#include <variant>
+
 /* internal */
+#include "../ContextLock.h"
 #include "../logging/LogInterface.h"
 #include "../result.h"
 #include "CircularBuffer.h"
+#include "message_encoding.h"
 
 namespace Coral
 {
 
+/*
+ * A max_messages value that stores each message's length inline, as a
+ * varint header in the data ring, so the number of messages is only limited
+ * by their total size.
+ */
+static constexpr std::size_t inline_lengths = 0;
+
 template <std::size_t depth, std::size_t max_messages = 1,
           byte_size element_t = std::byte,
-          std::size_t alignment = sizeof(element_t)>
+          std::size_t alignment = sizeof(element_t), class Lock = NoopLock>
 class MessageBuffer : public CircularBuffer<depth, element_t, alignment>
 {
+    using Base = CircularBuffer<depth, element_t, alignment>;
+
   public:
+    static constexpr bool Inline = max_messages == inline_lengths;
+
+    /* Varint length header sizes (inline lengths). */
+    static constexpr std::size_t header_size(std::size_t len)
+    {
+        return varint_size(len);
+    }
+
+    /* Contexts reserve a header that fits any length (see encode_header). */
+    static constexpr std::size_t max_header = header_size(depth);
+
     class MessageContext : public Coral::LogInterface<MessageContext>
     {
+      protected:
+        /* Held for the context's lifetime (so it's declared first). */
+        typename InstanceLock<Lock>::Guard guard;
+
       public:
-        MessageContext(MessageBuffer *_buf) : max(_buf->space()), buf(_buf)
+        MessageContext(MessageBuffer *_buf)
+            : guard(_buf->lock.guard()), max(_buf->context_max()), buf(_buf),
+              start(_buf->write_cursor), header(), aborted(false)
         {
-            /* Lock buffer, reset write count and determine maximum message
-             * size. */
-            buf->locked = true;
+            /*
+             * Reserve the (padded) length header ahead of the message if
+             * lengths are inline, reset write count and lock buffer (bounding
+             * its writes to this message).
+             */
+            if constexpr (Inline)
+            {
+                if (buf->space() >= max_header)
+                {
+                    header = buf->Base::reserve_write(max_header);
+                    buf->Base::commit_write(max_header);
+                }
+            }
             buf->write_count();
+            buf->context_limit = max;
+            buf->context_overflow = false;
+            buf->locked = true;
         }
 
         ~MessageContext()
         {
             auto len = buf->write_count();
 
-            /* Track message if written length is within bounds, otherwise
-             * reset buffer due to overflow. */
-            if (len <= max)
+            /*
+             * Track message if it was written within bounds, otherwise roll
+             * back just this message (earlier ones are left intact).
+             */
+            if (aborted or buf->context_overflow)
+            {
+                buf->rollback(start, len);
+            }
+            else if constexpr (Inline)
             {
-                buf->add_message(len);
+                if (not header.empty())
+                {
+                    auto encoded = encode_header(len, true);
+                    header.copy_from(encoded.data(), encoded.size());
+                    buf->add_message(len, max_header);
+                }
             }
             else
             {
-                buf->clear();
+                /*
+                 * Drop messages this one overwrote (overwrite mode), and
+                 * reject it if there's still no length slot for it.
+                 */
+                buf->make_room(len);
+                if (buf->num_messages < max_messages)
+                {
+                    buf->add_message(len);
+                }
+                else
+                {
+                    buf->rollback(start, len);
+                }
             }
 
             buf->locked = false;
         }
 
+        /* Discard the message (when the context closes). */
+        inline void abort(void)
+        {
+            aborted = true;
+        }
+
+        /* Elements the message can still grow by. */
+        inline std::size_t remaining(void)
+        {
+            return buf->room();
+        }
+
+        /* Whether or not a write didn't fit (rejecting the message). */
+        inline bool overflowed(void)
+        {
+            return buf->context_overflow;
+        }
+
         template <std::endian endianness, std::integral T>
         inline std::size_t custom_header(void)
         {
@@ -67,13 +157,23 @@ class MessageBuffer : public CircularBuffer<depth, element_t, alignment>
             return result + buf->template write<endianness>(elem);
         }
 
+        /*
+         * Format straight into the ring, truncated to what's left of the
+         * message's bounds (so it never overflows).
+         */
         void vlog_impl(const char *fmt, va_list args)
         {
-            char stack_buffer[BUFSIZ];
-            auto n = vsnprintf(stack_buffer, sizeof stack_buffer, fmt, args);
-            if (n > 0)
+            std::size_t remaining = buf->room();
+            if (remaining == 0)
             {
-                buf->write_n(stack_buffer, n);
+                return;
+            }
+
+            std::size_t n =
+                vformat_segments(buf->reserve_write(remaining), fmt, args);
+            if (n)
+            {
+                buf->commit_write(n);
             }
         }
 
@@ -81,38 +181,151 @@ class MessageBuffer : public CircularBuffer<depth, element_t, alignment>
 
       protected:
         MessageBuffer *buf;
+
+        /* Where the message starts (to roll back to). */
+        const RingCursor<depth> start;
+
+        /* Where the length goes (inline lengths). */
+        RingSegments<element_t> header;
+
+        bool aborted;
     };
 
     MessageBuffer()
         : CircularBuffer<depth, element_t, alignment>(), message_sizes(),
-          num_messages(0), data_size(0), locked(false)
+          num_messages(0), data_size(0), locked(false), overwrite(false),
+          claimed(0), evictions(0), rejections(0), context_limit(0),
+          context_overflow(false)
     {
     }
 
+    /**
+     * Have new messages evict the oldest (whole) messages when the buffer is
+     * full, rather than be rejected (e.g. for telemetry, where the newest
+     * data matters most). Messages larger than the buffer, or that would
+     * evict messages being viewed (see \ref get_messages), are still
+     * rejected.
+     *
+     * With inline lengths, a context can't overwrite messages as it writes
+     * (their lengths are in the ring), so its messages must fit the free
+     * space, as usual.
+     */
+    void set_overwrite(bool enabled = true)
+    {
+        auto guard = lock.guard();
+        overwrite = enabled;
+    }
+
+    /* The number of messages evicted in overwrite mode. */
+    inline uint64_t evicted(void)
+    {
+        return evictions;
+    }
+
+    /* The number of context messages rejected (overflowed or aborted). */
+    inline uint64_t rejected(void)
+    {
+        return rejections;
+    }
+
     MessageContext context(void)
     {
         return MessageContext(this);
     }
 
+    /*
+     * CircularBuffer's writers, checked against an open context's bounds
+     * first, so that a message that doesn't fit never overwrites unread
+     * ones. Writes that don't fit are dropped (and the context's message is
+     * rejected).
+     */
+    inline std::size_t write_single(const element_t elem)
+    {
+        return admit(1) ? Base::write_single(elem) : 0;
+    }
+
+    inline std::size_t write_n(const element_t *elem_array, std::size_t count)
+    {
+        return admit(count) ? Base::write_n(elem_array, count) : 0;
+    }
+
+    template <std::endian endianness, typename T>
+    inline std::size_t write(T elem)
+    {
+        return admit(write_size<T>())
+                   ? Base::template write<endianness>(elem)
+                   : 0;
+    }
+
+    template <std::endian endianness, endian_scalar T>
+    inline std::size_t write_array(std::span<const T> values)
+    {
+        return admit(values.size_bytes())
+                   ? Base::template write_array<endianness>(values)
+                   : 0;
+    }
+
+    /* In a context, at most the rest of the message's bounds. */
+    inline RingSegments<element_t> reserve_write(std::size_t count)
+    {
+        return Base::reserve_write(locked ? std::min(count, room()) : count);
+    }
+
+    inline void commit_write(std::size_t count)
+    {
+        if (admit(count))
+        {
+            Base::commit_write(count);
+        }
+    }
+
     inline std::size_t space(void)
     {
         return (data_size < depth) ? depth - data_size : 0;
     }
 
+    /* Elements a message of len elements occupies in the data ring. */
+    static constexpr std::size_t footprint(std::size_t len)
+    {
+        return Inline ? header_size(len) + len : len;
+    }
+
     inline bool full(std::size_t check = 0)
     {
+        if constexpr (Inline)
+        {
+            return data_size + footprint(check) > depth;
+        }
+
         return num_messages >= max_messages or (data_size + check > depth);
     }
 
     Result put_message(const element_t *data, std::size_t len)
     {
-        /* Need room for message size element and space in data buffer. */
-        auto result = len and not locked and not full(len);
+        auto guard = lock.guard();
+
+        /*
+         * Need room for message size element and space in data buffer
+         * (after evicting what it can, in overwrite mode).
+         */
+        auto result = len and not locked and footprint(len) <= depth;
+        if (result)
+        {
+            make_room(len);
+            result = not full(len);
+        }
 
         if (result)
         {
+            std::size_t header = 0;
+            if constexpr (Inline)
+            {
+                header = header_size(len);
+                this->write_n(encode_header(len, false).data(), header);
+            }
+
             this->write_n(data, len);
-            add_message(len);
+            add_message(len, header);
         }
 
         return ToResult(result);
@@ -128,7 +341,9 @@ class MessageBuffer : public CircularBuffer<depth, element_t, alignment>
 
     Result get_message(element_t *data, std::size_t &len)
     {
-        bool result = not locked and not empty();
+        auto guard = lock.guard();
+
+        bool result = not locked and not claimed and not empty();
 
         if (result)
         {
@@ -139,6 +354,77 @@ class MessageBuffer : public CircularBuffer<depth, element_t, alignment>
         return ToResult(result);
     }
 
+    /**
+     * View (up to views.size() of) the oldest messages in place, e.g. to
+     * send them with a single vectored write, stopping before a message
+     * that would take the total over \p max_bytes (the oldest is always
+     * viewed, so it can't hold up the rest). Viewed messages stay queued,
+     * and aren't evicted, until they're released.
+     *
+     * \param[out] views     Each message's elements (up to two segments).
+     * \param[in]  max_bytes The most bytes to view.
+     * \return               The number of messages viewed.
+     */
+    std::size_t get_messages(std::span<RingSegments<const element_t>> views,
+                             std::size_t max_bytes = depth)
+    {
+        auto guard = lock.guard();
+
+        if (locked)
+        {
+            return 0;
+        }
+
+        auto data = this->peek_read(data_size);
+        std::size_t count = 0;
+        std::size_t offset = 0;
+        std::size_t bytes = 0;
+
+        while (count < views.size() and count < num_messages)
+        {
+            std::size_t len;
+            if constexpr (Inline)
+            {
+                len = decode_varint(data, offset);
+            }
+            else
+            {
+                len = message_sizes.peek_read(num_messages)[count];
+            }
+
+            bytes += len * sizeof(element_t);
+            if (count and bytes > max_bytes)
+            {
+                break;
+            }
+
+            views[count++] = data.subrange(offset, len);
+            offset += len;
+        }
+
+        claimed = std::max(claimed, count);
+        return count;
+    }
+
+    /* Remove the count oldest messages (e.g. once they've been sent). */
+    Result release(std::size_t count)
+    {
+        auto guard = lock.guard();
+
+        bool result = not locked and count <= num_messages;
+
+        if (result)
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                this->consume(remove_message());
+            }
+            claimed -= std::min(claimed, count);
+        }
+
+        return ToResult(result);
+    }
+
     inline bool empty()
     {
         return num_messages == 0;
@@ -146,33 +432,167 @@ class MessageBuffer : public CircularBuffer<depth, element_t, alignment>
 
     inline void clear(void)
     {
-        this->reset();
-        message_sizes.reset();
-        /* Could track drops at some point. */
-        num_messages = 0;
-        data_size = 0;
+        auto guard = lock.guard();
+        clear_unlocked();
     }
 
+    /* Per-instance lock (if the lock policy has per-instance state). */
+    [[no_unique_address]] InstanceLock<Lock> lock;
+
   protected:
-    CircularBuffer<max_messages, std::size_t> message_sizes;
+    [[no_unique_address]] std::conditional_t<
+        Inline, std::monostate, CircularBuffer<max_messages, std::size_t>>
+        message_sizes;
     std::size_t num_messages;
     std::size_t data_size;
     bool locked;
+    bool overwrite;
+
+    /* The number of (oldest) messages viewed but not released. */
+    std::size_t claimed;
+
+    uint64_t evictions;
+    uint64_t rejections;
+
+    /* The open context's bounds, and whether a write exceeded them. */
+    std::size_t context_limit;
+    bool context_overflow;
+
+    /* Elements the open context's message can still grow by. */
+    inline std::size_t room(void)
+    {
+        std::size_t len = this->write_count(false);
+        return len < context_limit ? context_limit - len : 0;
+    }
+
+    /* Whether or not count more elements can be written. */
+    inline bool admit(std::size_t count)
+    {
+        if (locked and (context_overflow or count > room()))
+        {
+            context_overflow = true;
+        }
+
+        return not(locked and context_overflow);
+    }
+
+    /* Elements a value written with write() occupies. */
+    template <typename T> static constexpr std::size_t write_size(void)
+    {
+        if constexpr (std::is_pointer_v<T>)
+        {
+            return std::remove_cvref_t<std::remove_pointer_t<T>>::size;
+        }
+        else
+        {
+            return sizeof(T);
+        }
+    }
+
+    /*
+     * Discard a context's (len element) message by restoring the write
+     * cursor to where it started.
+     */
+    inline void rollback(const RingCursor<depth> &start, std::size_t len)
+    {
+        /* Drop messages it overwrote anyway (overwrite mode). */
+        if constexpr (not Inline)
+        {
+            make_room(len);
+        }
+
+        this->write_cursor = start;
+        rejections++;
+    }
+
+    inline void clear_unlocked(void)
+    {
+        this->reset();
+        if constexpr (not Inline)
+        {
+            message_sizes.reset();
+        }
+        /* Could track drops at some point. */
+        num_messages = 0;
+        claimed = 0;
+        data_size = 0;
+    }
+
+    /*
+     * Evict the oldest messages until len more elements fit (if enabled,
+     * and none are being viewed).
+     */
+    inline void make_room(std::size_t len)
+    {
+        while (overwrite and not claimed and not empty() and full(len))
+        {
+            this->consume(remove_message());
+            evictions++;
+        }
+    }
 
-    inline void add_message(std::size_t len)
+    /* The largest message a context can write. */
+    inline std::size_t context_max(void)
     {
-        message_sizes.write_single(len);
+        if constexpr (Inline)
+        {
+            return space() >= max_header ? space() - max_header : 0;
+        }
+
+        if (overwrite and not claimed)
+        {
+            return depth;
+        }
+
+        /* No room to track another message. */
+        return num_messages < max_messages ? space() : 0;
+    }
+
+    /* Encode a length header (see encode_varint). */
+    static std::array<element_t, max_header> encode_header(std::size_t len,
+                                                           bool padded)
+    {
+        return encode_varint<element_t, max_header>(len, padded);
+    }
+
+    inline void add_message(std::size_t len, std::size_t header = 0)
+    {
+        if constexpr (not Inline)
+        {
+            message_sizes.write_single(len);
+        }
         num_messages++;
-        data_size += len;
+        data_size += header + len;
     }
 
+    /* Remove the oldest message's length (and inline header). */
     inline auto remove_message(void)
     {
-        auto len = message_sizes.read_single();
+        std::size_t len = 0;
+
+        if constexpr (Inline)
+        {
+            std::size_t header = 0;
+            len = decode_varint(
+                this->peek_read(std::min(max_header, data_size)), header);
+            this->consume(header);
+            data_size -= header;
+        }
+        else
+        {
+            len = message_sizes.read_single();
+        }
+
         num_messages--;
         data_size -= len;
         return len;
     }
 };
 
+/* A message buffer holding as many messages as its data allows. */
+template <std::size_t depth, byte_size element_t = std::byte,
+          std::size_t alignment = sizeof(element_t), class Lock = NoopLock>
+using InlineMessageBuffer =
+    MessageBuffer<depth, inline_lengths, element_t, alignment, Lock>;
+
 } // namespace Coral
@@ -0,0 +1,91 @@
+#ifdef __linux__
+
+/* toolchain */
+#include <cerrno>
+
+/* linux */
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* internal */
+#include "../logging/macros.h"
+#include "MirroredStorage.h"
+
+namespace Coral
+{
+
+std::size_t system_page_size(void)
+{
+    return sysconf(_SC_PAGESIZE);
+}
+
+void *mirrored_map(std::size_t size)
+{
+    int fd = -1;
+
+    bool result = size and size % system_page_size() == 0;
+    if (not result)
+    {
+        errno = EINVAL;
+    }
+    LogErrnoIfNot(result);
+
+    if (result)
+    {
+        fd = memfd_create("coral-ring", MFD_CLOEXEC);
+        result = fd != -1;
+        LogErrnoIfNot(result);
+    }
+
+    void *base = MAP_FAILED;
+
+    if (result)
+    {
+        result = ftruncate(fd, size) == 0;
+        LogErrnoIfNot(result);
+    }
+
+    /* Reserve a region for both views, then map the file over each half. */
+    if (result)
+    {
+        base = mmap(nullptr, size * 2, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        result = base != MAP_FAILED;
+        LogErrnoIfNot(result);
+    }
+
+    if (result)
+    {
+        auto lower = static_cast<std::byte *>(base);
+        result = mmap(lower, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED and
+                 mmap(lower + size, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        LogErrnoIfNot(result);
+
+        if (not result)
+        {
+            munmap(base, size * 2);
+        }
+    }
+
+    /* The mappings keep the memory alive. */
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return result ? base : nullptr;
+}
+
+void mirrored_unmap(void *base, std::size_t size)
+{
+    if (base)
+    {
+        LogErrnoIfNot(munmap(base, size * 2) == 0);
+    }
+}
+
+} // namespace Coral
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * \file
+ * \brief Circular-buffer storage mapped twice into contiguous virtual memory.
+ */
+#pragma once
+
+#ifdef __linux__
+
+/* toolchain */
+#include <cstdint>
+#include <cstdlib>
+
+namespace Coral
+{
+
+/*
+ * The smallest page size, which mirrored storage sizes must be a multiple
+ * of at compile time (the system's page size may be larger, see
+ * \ref system_page_size).
+ */
+static constexpr std::size_t mirrored_page_size = 4096;
+
+/* The page size of the running system. */
+std::size_t system_page_size(void);
+
+/**
+ * Map \p size bytes of shared memory twice, back-to-back.
+ *
+ * \param[in] size Size of the underlying region (multiple of the system page
+ *                 size).
+ * \return         Base of the 2 * \p size mapping, or nullptr on failure
+ *                 (which is logged).
+ */
+void *mirrored_map(std::size_t size);
+
+/**
+ * Release a mapping created by \ref mirrored_map.
+ *
+ * \param[in] base Base of the mapping.
+ * \param[in] size Same as \ref mirrored_map.
+ */
+void mirrored_unmap(void *base, std::size_t size);
+
+/**
+ * Circular-buffer storage (Linux only) where the same pages are mapped twice
+ * back-to-back, so element depth + n aliases element n. Any window of up to
+ * depth elements is contiguous in memory, which lets wrapped regions be
+ * copied, encoded or handed to a syscall as a single span.
+ *
+ * \tparam depth     The number of elements stored. The storage size must be
+ *                   a multiple of the system page size (see \ref supported),
+ *                   otherwise construction aborts (as it does if mapping
+ *                   fails).
+ * \tparam element_t The kind of element stored.
+ * \tparam alignment Alignment of the first element (page aligned).
+ */
+template <std::size_t depth, typename element_t, std::size_t alignment>
+class MirroredStorage
+{
+    static_assert((depth * sizeof(element_t)) % mirrored_page_size == 0);
+    static_assert(alignment <= mirrored_page_size);
+
+  public:
+    static constexpr bool mirrored = true;
+
+    static constexpr std::size_t size = depth * sizeof(element_t);
+
+    MirroredStorage()
+        : elements(static_cast<element_t *>(mirrored_map(size)))
+    {
+        /* There's nowhere else to store elements. */
+        if (not elements)
+        {
+            std::abort();
+        }
+    }
+
+    /* Whether or not this storage can be mapped on the running system. */
+    static bool supported(void)
+    {
+        return size % system_page_size() == 0;
+    }
+
+    ~MirroredStorage()
+    {
+        mirrored_unmap(elements, size);
+    }
+
+    MirroredStorage(const MirroredStorage &) = delete;
+    MirroredStorage &operator=(const MirroredStorage &) = delete;
+
+    inline element_t *data(void)
+    {
+        return elements;
+    }
+
+    inline element_t &operator[](std::size_t index)
+    {
+        return elements[index];
+    }
+
+  protected:
+    element_t *elements;
+};
+
+}; // namespace Coral
+
+#endif
@@ -0,0 +1,384 @@
+/**
+ * \file
+ * \brief A bounded, lock-free, multi-producer multi-consumer buffer.
+ */
+#pragma once
+
+/* toolchain */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/* internal */
+#include "../Waiter.h"
+#include "../cache.h"
+#include "PcBufferReader.h"
+#include "PcBufferWriter.h"
+
+namespace Coral
+{
+
+/**
+ * A bounded queue that any number of producer and consumer threads can use
+ * concurrently without locking.
+ *
+ * Every slot carries a sequence number that encodes whether it's free for
+ * the producer at a given cursor position (sequence == position) or holds
+ * data for the consumer at that position (sequence == position + 1).
+ * Producers and consumers claim runs of slots by compare-and-swap on their
+ * shared cursor, then publish each slot by storing its next sequence number
+ * with release semantics. Multi-element operations claim a run of slots at
+ * once, so they're all-or-nothing with respect to other threads.
+ *
+ * Blocking operations park the calling thread (see \ref Waiter) until
+ * another thread makes progress.
+ *
+ * \tparam depth     The number of elements the buffer holds.
+ * \tparam element_t The kind of element the buffer stores (copied by value).
+ */
+template <std::size_t depth, typename element_t = std::byte>
+class MpmcBuffer
+    : public PcBufferWriter<MpmcBuffer<depth, element_t>, element_t>,
+      public PcBufferReader<MpmcBuffer<depth, element_t>, element_t>
+{
+    static_assert(depth > 0);
+
+  public:
+    static constexpr std::size_t Depth = depth;
+
+    MpmcBuffer()
+        : enqueue(), dequeue(), dropped(0), data_ready(), space_ready(),
+          slots()
+    {
+        for (std::size_t i = 0; i < depth; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * Queries (snapshots while other threads are active).
+     */
+
+    inline std::size_t data_available(void)
+    {
+        auto tail = dequeue.position.load(std::memory_order_acquire);
+        auto head = enqueue.position.load(std::memory_order_acquire);
+        return (head > tail) ? head - tail : 0;
+    }
+
+    inline std::size_t space_available(void)
+    {
+        return depth - std::min(depth, data_available());
+    }
+
+    inline bool empty(void)
+    {
+        return data_available() == 0;
+    }
+
+    inline bool full(void)
+    {
+        return data_available() >= depth;
+    }
+
+    inline uint64_t write_dropped(void)
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Producer interfaces.
+     */
+
+    Result push_impl(const element_t elem, bool drop = false)
+    {
+        return push_n_impl(&elem, 1, drop);
+    }
+
+    Result push_n_impl(const element_t *elem_array, std::size_t count,
+                       bool drop = false)
+    {
+        bool result = count <= depth and write(elem_array, count, false);
+
+        if (not result and drop)
+        {
+            dropped.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        return ToResult(result);
+    }
+
+    std::size_t try_push_n_impl(const element_t *elem_array, std::size_t count)
+    {
+        return write(elem_array, std::min(count, depth), true);
+    }
+
+    void push_blocking_impl(const element_t elem)
+    {
+        while (not ToBool(push_impl(elem)))
+        {
+            wait_for_space();
+        }
+    }
+
+    void push_n_blocking_impl(const element_t *elem_array, std::size_t count)
+    {
+        std::size_t pushed;
+        while (count)
+        {
+            pushed = try_push_n_impl(elem_array, count);
+            if (pushed)
+            {
+                if (elem_array)
+                {
+                    elem_array += pushed;
+                }
+                count -= pushed;
+            }
+            else
+            {
+                wait_for_space();
+            }
+        }
+    }
+
+    /**
+     * Block until at least \p count elements appear writable (at most the
+     * buffer depth) or \p timeout elapses. Other producers may claim the
+     * space first.
+     */
+    bool wait_for_space(std::size_t count = 1,
+                        std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        count = std::min(count, depth);
+        return space_ready.wait(
+            [this, count]() { return ready(enqueue, 0, count); }, timeout);
+    }
+
+    /*
+     * Consumer interfaces.
+     */
+
+    Result pop_impl(element_t &elem)
+    {
+        return pop_n_impl(&elem, 1);
+    }
+
+    Result pop_n_impl(element_t *elem_array, std::size_t count)
+    {
+        return ToResult(count <= depth and read(elem_array, count, false));
+    }
+
+    std::size_t try_pop_n_impl(element_t *elem_array, std::size_t count)
+    {
+        return read(elem_array, std::min(count, depth), true);
+    }
+
+    std::size_t pop_all_impl(element_t *elem_array = nullptr)
+    {
+        std::size_t result = 0;
+        std::size_t count;
+
+        while ((count = try_pop_n_impl(elem_array, depth)))
+        {
+            if (elem_array)
+            {
+                elem_array += count;
+            }
+            result += count;
+        }
+
+        return result;
+    }
+
+    void pop_blocking_impl(element_t &elem)
+    {
+        while (not ToBool(pop_impl(elem)))
+        {
+            wait_for_data();
+        }
+    }
+
+    void pop_n_blocking_impl(element_t *elem_array, std::size_t count)
+    {
+        std::size_t popped;
+        while (count)
+        {
+            popped = try_pop_n_impl(elem_array, count);
+            if (popped)
+            {
+                if (elem_array)
+                {
+                    elem_array += popped;
+                }
+                count -= popped;
+            }
+            else
+            {
+                wait_for_data();
+            }
+        }
+    }
+
+    /**
+     * Block until at least \p count elements appear readable (at most the
+     * buffer depth) or \p timeout elapses. Other consumers may claim the
+     * data first.
+     */
+    bool wait_for_data(std::size_t count = 1,
+                       std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        count = std::min(count, depth);
+        return data_ready.wait(
+            [this, count]() { return ready(dequeue, 1, count); }, timeout);
+    }
+
+  protected:
+    struct alignas(cache_line_size) Cursor
+    {
+        std::atomic<uint64_t> position = 0;
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        element_t value;
+    };
+
+    Cursor enqueue;
+    Cursor dequeue;
+
+    alignas(cache_line_size) std::atomic<uint64_t> dropped;
+
+    /* Waited on by consumers and producers respectively. */
+    Waiter data_ready;
+    Waiter space_ready;
+
+    alignas(cache_line_size) std::array<Slot, depth> slots;
+
+    static inline std::size_t index(uint64_t position)
+    {
+        return position % depth;
+    }
+
+    /*
+     * Whether or not the slot count positions past a cursor is ready (see
+     * claim), or the cursor has already moved on.
+     */
+    inline bool ready(Cursor &cursor, uint64_t offset, std::size_t count)
+    {
+        auto position = cursor.position.load(std::memory_order_acquire);
+        auto last = position + count - 1;
+        auto sequence =
+            slots[index(last)].sequence.load(std::memory_order_acquire);
+        return static_cast<int64_t>(sequence - (last + offset)) >= 0;
+    }
+
+    /*
+     * Claim a run of up to count slots from a cursor. A slot is ready when
+     * its sequence is its position plus offset (zero for producers, one for
+     * consumers). Returns the number of slots claimed (zero, or less than
+     * count only if partial progress is allowed) and their first position.
+     */
+    std::size_t claim(Cursor &cursor, uint64_t offset, std::size_t count,
+                      bool partial, uint64_t &start)
+    {
+        auto position = cursor.position.load(std::memory_order_relaxed);
+
+        while (count)
+        {
+            std::size_t ready = 0;
+            bool stale = false;
+
+            while (ready < count)
+            {
+                auto sequence = slots[index(position + ready)].sequence.load(
+                    std::memory_order_acquire);
+                auto diff = static_cast<int64_t>(sequence -
+                                                 (position + ready + offset));
+
+                if (diff != 0)
+                {
+                    /* Another thread has moved the cursor past us. */
+                    stale = diff > 0;
+                    break;
+                }
+
+                ready++;
+            }
+
+            if (stale)
+            {
+                position = cursor.position.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            /* Full (producer) or empty (consumer). */
+            if (ready == 0 or (ready < count and not partial))
+            {
+                break;
+            }
+
+            if (cursor.position.compare_exchange_weak(
+                    position, position + ready, std::memory_order_relaxed))
+            {
+                start = position;
+                return ready;
+            }
+        }
+
+        return 0;
+    }
+
+    std::size_t write(const element_t *elem_array, std::size_t count,
+                      bool partial)
+    {
+        uint64_t start = 0;
+        count = claim(enqueue, 0, count, partial, start);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto &slot = slots[index(start + i)];
+            if (elem_array)
+            {
+                slot.value = elem_array[i];
+            }
+            slot.sequence.store(start + i + 1, std::memory_order_release);
+        }
+
+        if (count)
+        {
+            data_ready.notify();
+        }
+
+        return count;
+    }
+
+    std::size_t read(element_t *elem_array, std::size_t count, bool partial)
+    {
+        uint64_t start = 0;
+        count = claim(dequeue, 1, count, partial, start);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto &slot = slots[index(start + i)];
+            if (elem_array)
+            {
+                elem_array[i] = slot.value;
+            }
+            slot.sequence.store(start + i + depth, std::memory_order_release);
+        }
+
+        if (count)
+        {
+            space_ready.notify();
+        }
+
+        return count;
+    }
+};
+
+}; // namespace Coral
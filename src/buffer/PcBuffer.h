@@ -5,54 +5,151 @@
 #pragma once
 
 /* toolchain */
+#include <chrono>
 #include <functional>
+#include <initializer_list>
 
 /* internal */
 #include "../ContextLock.h"
+#include "../Waiter.h"
 #include "CircularBuffer.h"
+#include "DynamicCircularBuffer.h"
 #include "PcBufferReader.h"
 #include "PcBufferState.h"
 #include "PcBufferWriter.h"
+#include "PcStreamBuf.h"
 
 namespace Coral
 {
 
-template <std::size_t depth, typename element_t = std::byte,
-          std::size_t alignment = sizeof(element_t), class Lock = NoopLock>
-class PcBuffer
-    : public PcBufferWriter<PcBuffer<depth, element_t, alignment, Lock>,
-                            element_t>,
-      public PcBufferReader<PcBuffer<depth, element_t, alignment, Lock>,
-                            element_t>
+/**
+ * A producer-consumer buffer that services itself through hooks bound at
+ * compile time (CRTP), so the service path can be inlined.
+ *
+ * The implementing class may provide any of:
+ *
+ * - service_data_impl(): invoked when data is available (e.g. to drain the
+ *   buffer).
+ * - service_space_impl(): invoked when space is available (e.g. to feed the
+ *   buffer).
+ * - has_data_service() / has_space_service(): whether or not the hooks are
+ *   currently active (defaults to whether or not they're provided).
+ *
+ * \tparam T         Implementing class (CRTP).
+ * \tparam depth     The number of elements the buffer holds, or
+ *                   \ref dynamic_depth to choose a capacity (and storage)
+ *                   at runtime (see \ref DynamicCircularBuffer).
+ * \tparam element_t The kind of element the buffer stores.
+ * \tparam alignment Alignment of the underlying storage.
+ * \tparam Lock      Lock policy (see \ref InstanceLock). Blocking
+ *                   operations only park threads if it shares the buffer
+ *                   between them (see \ref LockWaiter), otherwise they poll.
+ * \tparam Storage   Storage backend (see \ref ArrayStorage).
+ */
+template <class T, std::size_t depth, typename element_t = std::byte,
+          std::size_t alignment = sizeof(element_t), class Lock = NoopLock,
+          template <std::size_t, typename, std::size_t> class Storage =
+              ArrayStorage>
+class PcBufferBase : public PcBufferWriter<T, element_t>,
+                     public PcBufferReader<T, element_t>
 {
   public:
     static constexpr std::size_t Depth = depth;
 
-    using ServiceCallback =
-        std::function<void(PcBuffer<depth, element_t, alignment, Lock> *)>;
+    using Element = element_t;
 
-    PcBuffer(bool _auto_service = false,
-             ServiceCallback _space_available = nullptr,
-             ServiceCallback _data_available = nullptr)
-        : state(depth), buffer(), space_available(_space_available),
-          data_available(_data_available), auto_service(_auto_service)
+    static constexpr bool Dynamic = depth == dynamic_depth;
+
+    using Buffer = std::conditional_t<
+        Dynamic, DynamicCircularBuffer<element_t, alignment>,
+        CircularBuffer<depth, element_t, alignment, Storage>>;
+
+    static constexpr bool Mirrored = Buffer::Mirrored;
+
+    PcBufferBase(bool _auto_service = false)
+        requires(not Dynamic)
+        : state(depth, sizeof(element_t)), buffer(),
+          auto_service(_auto_service), data_ready(), space_ready(),
+          data_threshold(0), space_threshold(0), edge_triggered(false),
+          overwrite(false)
     {
     }
 
-    void set_space_available(ServiceCallback _space_available = nullptr)
+    /* Use (but don't own) existing storage. */
+    PcBufferBase(std::span<element_t> storage, bool _auto_service = false)
+        requires Dynamic
+        : state(storage.size(), sizeof(element_t)), buffer(storage),
+          auto_service(_auto_service), data_ready(), space_ready(),
+          data_threshold(0), space_threshold(0), edge_triggered(false),
+          overwrite(false)
     {
-        /* Don't allow double assignment. */
-        assert(not _space_available or
-               (_space_available and space_available == nullptr));
-        space_available = _space_available;
     }
 
-    void set_data_available(ServiceCallback _data_available = nullptr)
+    /* Allocate (and own) storage for capacity elements. */
+    PcBufferBase(std::size_t capacity, std::pmr::memory_resource *resource,
+                 bool _auto_service = false)
+        requires Dynamic
+        : state(capacity, sizeof(element_t)), buffer(capacity, resource),
+          auto_service(_auto_service), data_ready(), space_ready(),
+          data_threshold(0), space_threshold(0), edge_triggered(false),
+          overwrite(false)
     {
-        /* Don't allow double assignment. */
-        assert(not _data_available or
-               (_data_available and data_available == nullptr));
-        data_available = _data_available;
+    }
+
+    /* The number of elements the buffer holds. */
+    inline std::size_t capacity(void) const
+    {
+        if constexpr (Dynamic)
+        {
+            return state.size;
+        }
+        else
+        {
+            return depth;
+        }
+    }
+
+    /**
+     * Coalesce service callbacks. The data-available callback only fires
+     * once at least \p data elements are buffered (a high watermark) and the
+     * space-available callback once at least \p space elements are free (a
+     * low watermark). Thresholds of zero (the default) fire on every
+     * operation. Suppressed invocations are counted in \ref state.
+     *
+     * \param[in] data  Data threshold for the data-available callback.
+     * \param[in] space Space threshold for the space-available callback.
+     * \param[in] edge  Only fire as an operation crosses a threshold, rather
+     *                  than whenever the buffer is beyond it (thresholds of
+     *                  zero then fire as the buffer stops being empty or
+     *                  full). Auto-service is always level-triggered, and
+     *                  \ref flush always services the buffer.
+     */
+    void set_service_thresholds(std::size_t data, std::size_t space,
+                                bool edge = false)
+    {
+        auto guard = lock.guard();
+        data_threshold = std::min(data, capacity());
+        space_threshold = std::min(space, capacity());
+        edge_triggered = edge;
+    }
+
+    /**
+     * Have writes to a full buffer evict (and count, see
+     * \ref BufferMetrics::dropped_evicted) the oldest elements, so the
+     * newest data wins, rather than be rejected. Writes larger than the
+     * buffer are still dropped, and zero-copy writes (\ref reserve_write)
+     * only ever use free space.
+     *
+     * Readers are never stalled on and never stall a writer. Zero-copy
+     * readers (\ref peek_read) may have elements evicted from under them
+     * though, so should prefer pop in this mode.
+     *
+     * \param[in] enabled Whether or not to overwrite.
+     */
+    void set_overwrite(bool enabled = true)
+    {
+        auto guard = lock.guard();
+        overwrite = enabled;
     }
 
     inline bool empty(void)
@@ -67,41 +164,122 @@ class PcBuffer
 
     inline void clear()
     {
-        Lock lock;
+        auto guard = lock.guard();
 
         /* Reset state. */
         state.reset();
 
         uint32_t tmp;
         buffer.poll_metrics(tmp, tmp);
+
+        space_ready.notify();
     }
 
     inline element_t peek()
     {
+        auto guard = lock.guard();
         return buffer.peek();
     }
 
+    /**
+     * Copy elements out without consuming them.
+     *
+     * \param[out] elem_array Elements copied.
+     * \param[in]  count      Maximum number of elements to copy.
+     * \param[in]  offset     Number of elements to skip first.
+     * \return                The number of elements copied.
+     */
+    std::size_t peek_n(element_t *elem_array, std::size_t count,
+                       std::size_t offset = 0)
+    {
+        auto guard = lock.guard();
+        return buffer.peek_read(state.data_available())
+            .copy_to(elem_array, offset, count);
+    }
+
+    /**
+     * Find the first occurrence of an element (without consuming anything),
+     * scanning both ring segments.
+     *
+     * \param[in]  elem   Element to find.
+     * \param[out] offset Its offset from the next element to be read.
+     * \param[in]  start  Offset to start searching from.
+     * \return            Whether or not the element was found.
+     */
+    Result find(const element_t elem, std::size_t &offset,
+                std::size_t start = 0)
+    {
+        auto guard = lock.guard();
+        auto segments = buffer.peek_read(state.data_available());
+        offset = segments.find(elem, start);
+        return ToResult(offset < segments.size());
+    }
+
+    /**
+     * Pop a frame: elements up to and including the first \p delimiter, or
+     * \p count elements if there's no delimiter among them (check the last
+     * element popped to tell a complete frame from a partial one).
+     *
+     * \param[in]  delimiter  Frame delimiter.
+     * \param[out] elem_array Elements popped.
+     * \param[in]  count      Maximum number of elements to pop.
+     * \return                The number of elements popped.
+     */
+    std::size_t pop_until(const element_t delimiter, element_t *elem_array,
+                          std::size_t count)
+    {
+        /* Allow a pop request to feed the buffer. */
+        if (auto_service)
+        {
+            poll_space();
+        }
+
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            auto segments = buffer.peek_read(
+                std::min(count, state.data_available()));
+
+            count = std::min(segments.find(delimiter) + 1, segments.size());
+            if (count)
+            {
+                state.decrement_data(count);
+                buffer.read_n(elem_array, count);
+                fire = space_trigger(count);
+            }
+        }
+
+        if (count)
+        {
+            space_added(fire);
+        }
+
+        return count;
+    }
+
     Result pop_impl(element_t &elem)
     {
         /* Allow a pop request to feed the buffer. */
         if (auto_service)
         {
-            service_space();
+            poll_space();
         }
 
         bool result;
+        bool fire = false;
         {
-            Lock lock;
+            auto guard = lock.guard();
             result = state.decrement_data();
             if (result)
             {
                 buffer.read_single(elem);
+                fire = space_trigger(1);
             }
         }
 
         if (result)
         {
-            service_space();
+            space_added(fire);
         }
 
         return ToResult(result);
@@ -112,22 +290,24 @@ class PcBuffer
         /* Allow a pop request to feed the buffer. */
         if (auto_service)
         {
-            service_space();
+            poll_space();
         }
 
         bool result;
+        bool fire = false;
         {
-            Lock lock;
+            auto guard = lock.guard();
             result = state.decrement_data(count);
             if (result)
             {
                 buffer.read_n(elem_array, count);
+                fire = space_trigger(count);
             }
         }
 
         if (result)
         {
-            service_space();
+            space_added(fire);
         }
 
         return ToResult(result);
@@ -135,11 +315,27 @@ class PcBuffer
 
     std::size_t try_pop_n_impl(element_t *elem_array, std::size_t count)
     {
-        count = std::min(count, state.data_available());
+        /* Allow a pop request to feed the buffer. */
+        if (auto_service)
+        {
+            poll_space();
+        }
+
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            count = std::min(count, state.data_available());
+            if (count)
+            {
+                state.decrement_data(count);
+                buffer.read_n(elem_array, count);
+                fire = space_trigger(count);
+            }
+        }
 
         if (count)
         {
-            count = ToBool(pop_n_impl(elem_array, count)) ? count : 0;
+            space_added(fire);
         }
 
         return count;
@@ -147,34 +343,124 @@ class PcBuffer
 
     std::size_t pop_all_impl(element_t *elem_array = nullptr)
     {
-        std::size_t result = state.data_available();
+        return try_pop_n_impl(elem_array, capacity());
+    }
+
+    void pop_blocking_impl(element_t &elem)
+    {
+        while (not ToBool(pop_impl(elem)))
+        {
+            wait_for_data();
+        }
+    }
+
+    void pop_n_blocking_impl(element_t *elem_array, std::size_t count)
+    {
+        std::size_t popped;
+        while (count)
+        {
+            popped = try_pop_n_impl(elem_array, count);
+            if (popped)
+            {
+                if (elem_array)
+                {
+                    elem_array += popped;
+                }
+                count -= popped;
+            }
+            else
+            {
+                wait_for_data();
+            }
+        }
+    }
+
+    /**
+     * Block until at least \p count elements can be read (at most the buffer
+     * depth) or \p timeout elapses.
+     *
+     * If a space-available callback is set it's expected to feed the buffer,
+     * so it's invoked until there's enough data. Otherwise the calling thread
+     * parks until a producer adds data (or polls, see \ref LockWaiter).
+     *
+     * \return Whether or not enough data is available.
+     */
+    bool wait_for_data(std::size_t count = 1,
+                       std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        count = std::min(count, capacity());
+        auto ready = [this, count]() { return has_data(count); };
+
+        if (has_space_hook())
+        {
+            return service_until(
+                ready, [this]() { service_space(true); }, timeout);
+        }
+
+        return data_ready.wait(ready, timeout);
+    }
+
+    /*
+     * Zero-copy reading: view (up to \p count) available elements in-place,
+     * then release them with consume.
+     */
+    RingSegments<const element_t> peek_read(std::size_t count = depth)
+    {
+        /* Allow a read request to feed the buffer. */
+        if (auto_service)
+        {
+            poll_space();
+        }
+
+        auto guard = lock.guard();
+        return buffer.peek_read(std::min(count, state.data_available()));
+    }
+
+    Result consume(std::size_t count)
+    {
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            result = state.decrement_data(count);
+            if (result)
+            {
+                buffer.consume(count);
+                fire = space_trigger(count);
+            }
+        }
+
         if (result)
         {
-            result = ToBool(pop_n_impl(elem_array, result)) ? result : 0;
+            space_added(fire);
         }
-        return result;
+
+        return ToResult(result);
     }
 
     Result push_impl(const element_t elem, bool drop = false)
     {
         if (auto_service)
         {
-            service_data();
+            poll_data();
         }
 
         bool result;
+        bool fire = false;
         {
-            Lock lock;
+            auto guard = lock.guard();
+            make_room(1);
             result = state.increment_data(drop);
             if (result)
             {
                 buffer.write_single(elem);
+                fire = data_trigger(1);
             }
         }
 
         if (result)
         {
-            service_data();
+            data_added(fire);
         }
 
         return ToResult(result);
@@ -182,19 +468,45 @@ class PcBuffer
 
     void push_blocking_impl(const element_t elem)
     {
-        while (full())
+        while (not ToBool(push_impl(elem)))
         {
-            service_data(true);
+            wait_for_space();
         }
-        push_impl(elem);
     }
 
+    /*
+     * Block until the buffer is empty, either by servicing it directly (if
+     * a data-available callback is set) or waiting for consumers.
+     */
     inline void flush(void)
     {
-        while (!empty())
+        wait_for_space(capacity());
+    }
+
+    /**
+     * Block until at least \p count elements can be written (at most the
+     * buffer depth) or \p timeout elapses.
+     *
+     * If a data-available callback is set it's expected to drain the buffer,
+     * so it's invoked until there's enough space (as before). Otherwise the
+     * calling thread parks until a consumer makes space (or polls, see
+     * \ref LockWaiter).
+     *
+     * \return Whether or not there's enough space.
+     */
+    bool wait_for_space(std::size_t count = 1,
+                        std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        count = std::min(count, capacity());
+        auto ready = [this, count]() { return has_space(count); };
+
+        if (has_data_hook())
         {
-            service_data(true);
+            return service_until(
+                ready, [this]() { service_data(true); }, timeout);
         }
+
+        return space_ready.wait(ready, timeout);
     }
 
     Result push_n_impl(const element_t *elem_array, std::size_t count,
@@ -202,22 +514,25 @@ class PcBuffer
     {
         if (auto_service)
         {
-            service_data();
+            poll_data();
         }
 
         bool result;
+        bool fire = false;
         {
-            Lock lock;
+            auto guard = lock.guard();
+            make_room(count);
             result = state.increment_data(drop, count);
             if (result)
             {
                 buffer.write_n(elem_array, count);
+                fire = data_trigger(count);
             }
         }
 
         if (result)
         {
-            service_data();
+            data_added(fire);
         }
 
         return ToResult(result);
@@ -225,11 +540,28 @@ class PcBuffer
 
     std::size_t try_push_n_impl(const element_t *elem_array, std::size_t count)
     {
-        count = std::min(count, state.space_available());
+        if (auto_service)
+        {
+            poll_data();
+        }
+
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            count = std::min(count, overwrite ? capacity()
+                                              : state.space_available());
+            if (count)
+            {
+                make_room(count);
+                state.increment_data(false, count);
+                buffer.write_n(elem_array, count);
+                fire = data_trigger(count);
+            }
+        }
 
         if (count)
         {
-            count = ToBool(push_n_impl(elem_array, count)) ? count : 0;
+            data_added(fire);
         }
 
         return count;
@@ -240,19 +572,351 @@ class PcBuffer
         std::size_t chunk;
         while (count)
         {
-            chunk = std::min(depth, count);
-
-            while (!state.has_enough_space(chunk))
-            {
-                service_data(true);
-            }
+            chunk = std::min(capacity(), count);
 
             if (ToBool(push_n_impl(elem_array, chunk)))
             {
                 elem_array += chunk;
                 count -= chunk;
             }
+            else
+            {
+                wait_for_space(chunk);
+            }
+        }
+    }
+
+    /*
+     * Zero-copy writing: populate (up to \p count) free elements in-place,
+     * then publish them with commit_write.
+     */
+    RingSegments<element_t> reserve_write(std::size_t count = depth)
+    {
+        /* Allow a write request to drain the buffer. */
+        if (auto_service)
+        {
+            poll_data();
+        }
+
+        auto guard = lock.guard();
+        return buffer.reserve_write(std::min(count, state.space_available()));
+    }
+
+    Result commit_write(std::size_t count, bool drop = false)
+    {
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            result = state.increment_data(drop, count);
+            if (result)
+            {
+                buffer.commit_write(count);
+                fire = data_trigger(count);
+            }
+        }
+
+        if (result)
+        {
+            data_added(fire);
+        }
+
+        return ToResult(result);
+    }
+
+    /**
+     * Push an array of values, converted to \p endianness, all-or-nothing
+     * (see \ref CircularBuffer::write_array).
+     *
+     * \param[in] values Values to push.
+     * \param[in] drop   Same as \ref PcBufferWriter::push_n.
+     * \return           Whether or not every value was pushed.
+     */
+    template <std::endian endianness, endian_scalar value_t>
+    Result push_array(std::span<const value_t> values, bool drop = false)
+        requires byte_size<element_t>
+    {
+        if (auto_service)
+        {
+            poll_data();
+        }
+
+        std::size_t count = values.size_bytes();
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            make_room(count);
+            result = state.increment_data(drop, count);
+            if (result)
+            {
+                buffer.template write_array<endianness>(values);
+                fire = data_trigger(count);
+            }
+        }
+
+        if (result)
+        {
+            data_added(fire);
+        }
+
+        return ToResult(result);
+    }
+
+    /**
+     * Pop an array of values, converted from \p endianness, all-or-nothing
+     * (see \ref CircularBuffer::read_array).
+     *
+     * \param[out] values Values to pop.
+     * \return            Whether or not every value was popped.
+     */
+    template <std::endian endianness, endian_scalar value_t>
+    Result pop_array(std::span<value_t> values)
+        requires byte_size<element_t>
+    {
+        if (auto_service)
+        {
+            poll_space();
+        }
+
+        std::size_t count = values.size_bytes();
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            result = state.decrement_data(count);
+            if (result)
+            {
+                buffer.template read_array<endianness>(values);
+                fire = space_trigger(count);
+            }
+        }
+
+        if (result)
+        {
+            space_added(fire);
+        }
+
+        return ToResult(result);
+    }
+
+    /**
+     * Push several pieces (e.g. a header, a payload held elsewhere and a
+     * trailer) as one all-or-nothing transaction: a consumer sees either
+     * none of them or all of them, contiguously.
+     *
+     * \param[in] pieces Pieces to push, in order.
+     * \param[in] drop   Same as \ref PcBufferWriter::push_n.
+     * \return           Whether or not every piece was pushed.
+     */
+    Result push_v(std::span<const std::span<const element_t>> pieces,
+                  bool drop = false)
+    {
+        if (auto_service)
+        {
+            poll_data();
+        }
+
+        std::size_t count = 0;
+        for (auto piece : pieces)
+        {
+            count += piece.size();
+        }
+
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            make_room(count);
+            result = state.increment_data(drop, count);
+            if (result)
+            {
+                for (auto piece : pieces)
+                {
+                    if (not piece.empty())
+                    {
+                        buffer.write_n(piece.data(), piece.size());
+                    }
+                }
+                fire = data_trigger(count);
+            }
+        }
+
+        if (result)
+        {
+            data_added(fire);
+        }
+
+        return ToResult(result);
+    }
+
+    inline Result push_v(
+        std::initializer_list<std::span<const element_t>> pieces,
+        bool drop = false)
+    {
+        return push_v(std::span(pieces.begin(), pieces.size()), drop);
+    }
+
+    /**
+     * Pop into several pieces (e.g. a header, a payload and a trailer) as
+     * one all-or-nothing transaction.
+     *
+     * \param[out] pieces Pieces to fill, in order.
+     * \return            Whether or not every piece was filled.
+     */
+    Result pop_v(std::span<const std::span<element_t>> pieces)
+    {
+        /* Allow a pop request to feed the buffer. */
+        if (auto_service)
+        {
+            poll_space();
+        }
+
+        std::size_t count = 0;
+        for (auto piece : pieces)
+        {
+            count += piece.size();
+        }
+
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            result = state.decrement_data(count);
+            if (result)
+            {
+                for (auto piece : pieces)
+                {
+                    if (not piece.empty())
+                    {
+                        buffer.read_n(piece.data(), piece.size());
+                    }
+                }
+                fire = space_trigger(count);
+            }
+        }
+
+        if (result)
+        {
+            space_added(fire);
+        }
+
+        return ToResult(result);
+    }
+
+    inline Result pop_v(std::initializer_list<std::span<element_t>> pieces)
+    {
+        return pop_v(std::span(pieces.begin(), pieces.size()));
+    }
+
+    /**
+     * Push a struct, encoded to \p endianness directly in the ring (only a
+     * struct straddling the end of the ring is staged on the stack).
+     *
+     * \param[in] elem The struct to push.
+     * \param[in] drop Same as \ref PcBufferWriter::push_n.
+     * \return         Whether or not the struct was pushed.
+     */
+    template <std::endian endianness = default_endian, ifgen_struct S>
+    Result push_struct(const S &elem, bool drop = false)
+        requires byte_size<element_t>
+    {
+        if (auto_service)
+        {
+            poll_data();
+        }
+
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            make_room(S::size);
+            result = state.increment_data(drop, S::size);
+            if (result)
+            {
+                auto region = buffer.reserve_write(S::size);
+                if (region.contiguous())
+                {
+                    elem.template encode<endianness>(
+                        reinterpret_cast<typename S::Buffer *>(
+                            region.first.data()));
+                }
+                else
+                {
+                    typename S::Buffer temp;
+                    elem.template encode<endianness>(&temp);
+                    region.copy_from(
+                        reinterpret_cast<const element_t *>(temp.data()),
+                        S::size);
+                }
+                buffer.commit_write(S::size);
+                fire = data_trigger(S::size);
+            }
+        }
+
+        if (result)
+        {
+            data_added(fire);
+        }
+
+        return ToResult(result);
+    }
+
+    /**
+     * Pop a struct, decoded from \p endianness directly out of the ring
+     * (see \ref push_struct).
+     *
+     * \param[out] elem The struct to pop into.
+     * \return          Whether or not a whole struct was popped.
+     */
+    template <std::endian endianness = default_endian, ifgen_struct S>
+    Result pop_struct(S &elem)
+        requires byte_size<element_t>
+    {
+        /* Allow a pop request to feed the buffer. */
+        if (auto_service)
+        {
+            poll_space();
+        }
+
+        bool result;
+        bool fire = false;
+        {
+            auto guard = lock.guard();
+            result = state.decrement_data(S::size);
+            if (result)
+            {
+                auto region = buffer.peek_read(S::size);
+                if (region.contiguous())
+                {
+                    elem.template decode<endianness>(
+                        reinterpret_cast<const typename S::Buffer *>(
+                            region.first.data()));
+                }
+                else
+                {
+                    typename S::Buffer temp;
+                    region.copy_to(reinterpret_cast<element_t *>(temp.data()),
+                                   0, S::size);
+                    elem.template decode<endianness>(&temp);
+                }
+                buffer.consume(S::size);
+                fire = space_trigger(S::size);
+            }
         }
+
+        if (result)
+        {
+            space_added(fire);
+        }
+
+        return ToResult(result);
+    }
+
+    /* A snapshot of buffer metrics (see \ref PcBufferState::metrics). */
+    inline BufferMetrics metrics(void) const
+    {
+        return state.metrics();
     }
 
     inline const element_t *head(void)
@@ -262,37 +926,333 @@ class PcBuffer
 
     PcBufferState state;
 
-  protected:
-    CircularBuffer<depth, element_t, alignment> buffer;
+    /* Per-instance lock (if the lock policy has per-instance state). */
+    [[no_unique_address]] InstanceLock<Lock> lock;
 
-    ServiceCallback space_available;
-    ServiceCallback data_available;
+  protected:
+    Buffer buffer;
 
     bool auto_service;
 
+    /* Waited on by consumers and producers respectively. */
+    [[no_unique_address]] LockWaiter<Lock> data_ready;
+    [[no_unique_address]] LockWaiter<Lock> space_ready;
+
+    std::size_t data_threshold;
+    std::size_t space_threshold;
+    bool edge_triggered;
+
+    bool overwrite;
+
+    /*
+     * Called with the lock held before writing count elements: evict the
+     * oldest data to fit them (in overwrite mode).
+     */
+    inline void make_room(std::size_t count)
+    {
+        std::size_t space = state.space_available();
+
+        if (overwrite and count > space and count <= capacity())
+        {
+            state.evict(count - space);
+            buffer.consume(count - space);
+        }
+    }
+
+    /*
+     * Whether or not an operation that moved count elements, leaving level
+     * elements of data or space, has met a service threshold.
+     */
+    inline bool triggered(std::size_t level, std::size_t count,
+                          std::size_t threshold)
+    {
+        return level >= threshold and
+               (not edge_triggered or
+                level - count < std::max(threshold, std::size_t(1)));
+    }
+
+    /* Called with the lock held after data is added. */
+    inline bool data_trigger(std::size_t count)
+    {
+        bool result = has_data_hook() and
+                      triggered(state.data_available(), count, data_threshold);
+
+        if (has_data_hook() and not result)
+        {
+            state.data_suppressed++;
+        }
+
+        return result;
+    }
+
+    /* Called with the lock held after data is removed. */
+    inline bool space_trigger(std::size_t count)
+    {
+        bool result =
+            has_space_hook() and
+            triggered(state.space_available(), count, space_threshold);
+
+        if (has_space_hook() and not result)
+        {
+            state.space_suppressed++;
+        }
+
+        return result;
+    }
+
+    inline void data_added(bool fire)
+    {
+        data_ready.notify();
+        if (fire)
+        {
+            service_data();
+        }
+    }
+
+    inline void space_added(bool fire)
+    {
+        space_ready.notify();
+        if (fire)
+        {
+            service_space();
+        }
+    }
+
+    /* Auto-service ahead of an operation (level-triggered). */
+    inline void poll_data(void)
+    {
+        if (has_data_hook())
+        {
+            bool fire = data_threshold == 0;
+            if (not fire)
+            {
+                auto guard = lock.guard();
+                fire = state.data_available() >= data_threshold;
+                if (not fire)
+                {
+                    state.data_suppressed++;
+                }
+            }
+
+            if (fire)
+            {
+                service_data();
+            }
+        }
+    }
+
+    inline void poll_space(void)
+    {
+        if (has_space_hook())
+        {
+            bool fire = space_threshold == 0;
+            if (not fire)
+            {
+                auto guard = lock.guard();
+                fire = state.space_available() >= space_threshold;
+                if (not fire)
+                {
+                    state.space_suppressed++;
+                }
+            }
+
+            if (fire)
+            {
+                service_space();
+            }
+        }
+    }
+
+    inline bool has_data(std::size_t count)
+    {
+        auto guard = lock.guard();
+        return state.has_enough_data(count);
+    }
+
+    inline bool has_space(std::size_t count)
+    {
+        auto guard = lock.guard();
+        return state.has_enough_space(count);
+    }
+
+    /* Invoke a service callback until a predicate holds or time runs out. */
+    template <typename Predicate, typename Service>
+    static bool service_until(Predicate ready, Service service,
+                              std::chrono::nanoseconds timeout)
+    {
+        using clock = std::chrono::steady_clock;
+        auto deadline = clock::now() + timeout;
+        bool result = ready();
+
+        while (not result)
+        {
+            if (timeout >= timeout.zero() and clock::now() >= deadline)
+            {
+                break;
+            }
+            service();
+            result = ready();
+        }
+
+        return result;
+    }
+
+    inline T &derived(void)
+    {
+        return *static_cast<T *>(this);
+    }
+
+    inline bool has_data_hook(void)
+    {
+        if constexpr (requires(T &impl) { impl.has_data_service(); })
+        {
+            return derived().has_data_service();
+        }
+        else
+        {
+            return requires(T &impl) { impl.service_data_impl(); };
+        }
+    }
+
+    inline bool has_space_hook(void)
+    {
+        if constexpr (requires(T &impl) { impl.has_space_service(); })
+        {
+            return derived().has_space_service();
+        }
+        else
+        {
+            return requires(T &impl) { impl.service_space_impl(); };
+        }
+    }
+
     inline void service_data(bool required = false)
     {
         (void)required;
-        assert(data_available or not required);
+        assert(has_data_hook() or not required);
 
-        if (data_available)
+        if constexpr (requires(T &impl) { impl.service_data_impl(); })
         {
-            data_available(this);
+            if (has_data_hook())
+            {
+                state.data_callbacks.add_concurrent();
+                derived().service_data_impl();
+            }
         }
     }
 
     inline void service_space(bool required = false)
     {
         (void)required;
-        assert(space_available or not required);
+        assert(has_space_hook() or not required);
 
-        if (space_available)
+        if constexpr (requires(T &impl) { impl.service_space_impl(); })
         {
-            space_available(this);
+            if (has_space_hook())
+            {
+                state.space_callbacks.add_concurrent();
+                derived().service_space_impl();
+            }
         }
     }
 };
 
+/**
+ * A producer-consumer buffer that services itself through callbacks set at
+ * runtime.
+ */
+template <std::size_t depth, typename element_t = std::byte,
+          std::size_t alignment = sizeof(element_t), class Lock = NoopLock,
+          template <std::size_t, typename, std::size_t> class Storage =
+              ArrayStorage>
+class PcBuffer
+    : public PcBufferBase<PcBuffer<depth, element_t, alignment, Lock, Storage>,
+                          depth, element_t, alignment, Lock, Storage>
+{
+  public:
+    using ServiceCallback = std::function<void(
+        PcBuffer<depth, element_t, alignment, Lock, Storage> *)>;
+
+    PcBuffer(bool _auto_service = false,
+             ServiceCallback _space_available = nullptr,
+             ServiceCallback _data_available = nullptr)
+        requires(depth != dynamic_depth)
+        : PcBufferBase<PcBuffer<depth, element_t, alignment, Lock, Storage>,
+                       depth, element_t, alignment, Lock,
+                       Storage>(_auto_service),
+          space_available(_space_available), data_available(_data_available)
+    {
+    }
+
+    PcBuffer(std::span<element_t> storage, bool _auto_service = false,
+             ServiceCallback _space_available = nullptr,
+             ServiceCallback _data_available = nullptr)
+        requires(depth == dynamic_depth)
+        : PcBufferBase<PcBuffer<depth, element_t, alignment, Lock, Storage>,
+                       depth, element_t, alignment, Lock,
+                       Storage>(storage, _auto_service),
+          space_available(_space_available), data_available(_data_available)
+    {
+    }
+
+    PcBuffer(std::size_t capacity, std::pmr::memory_resource *resource =
+                                       std::pmr::get_default_resource(),
+             bool _auto_service = false,
+             ServiceCallback _space_available = nullptr,
+             ServiceCallback _data_available = nullptr)
+        requires(depth == dynamic_depth)
+        : PcBufferBase<PcBuffer<depth, element_t, alignment, Lock, Storage>,
+                       depth, element_t, alignment, Lock,
+                       Storage>(capacity, resource, _auto_service),
+          space_available(_space_available), data_available(_data_available)
+    {
+    }
+
+    void set_space_available(ServiceCallback _space_available = nullptr)
+    {
+        /* Don't allow double assignment. */
+        assert(not _space_available or
+               (_space_available and space_available == nullptr));
+        space_available = _space_available;
+    }
+
+    void set_data_available(ServiceCallback _data_available = nullptr)
+    {
+        /* Don't allow double assignment. */
+        assert(not _data_available or
+               (_data_available and data_available == nullptr));
+        data_available = _data_available;
+    }
+
+    /*
+     * Service hooks (see \ref PcBufferBase).
+     */
+
+    inline bool has_data_service(void)
+    {
+        return static_cast<bool>(data_available);
+    }
+
+    inline bool has_space_service(void)
+    {
+        return static_cast<bool>(space_available);
+    }
+
+    inline void service_data_impl(void)
+    {
+        data_available(this);
+    }
+
+    inline void service_space_impl(void)
+    {
+        space_available(this);
+    }
+
+  protected:
+    ServiceCallback space_available;
+    ServiceCallback data_available;
+};
+
 /* Convenient aliases. */
 template <std::size_t depth, std::size_t alignment = sizeof(std::byte),
           class Lock = NoopLock>
@@ -304,30 +1264,64 @@ template <std::size_t depth, std::size_t alignment = sizeof(wchar_t),
           class Lock = NoopLock>
 using WcharBuffer = PcBuffer<depth, wchar_t, alignment, Lock>;
 
+/* A buffer with its capacity (and storage) chosen at runtime. */
+template <typename element_t = std::byte, class Lock = NoopLock,
+          std::size_t alignment = sizeof(element_t)>
+using DynamicPcBuffer = PcBuffer<dynamic_depth, element_t, alignment, Lock>;
+
 /*
  * Stream interfaces.
  */
 
-template <std::size_t depth, typename element_t = std::byte,
-          std::size_t alignment = sizeof(element_t), class Lock = NoopLock>
+/*
+ * Stream operators transfer whatever is immediately available (input the
+ * stream has buffered, or data in the buffer) directly to or from the
+ * buffer's storage. See \ref PcStreamBuf for full stream access.
+ */
+template <class T, std::size_t depth, typename element_t,
+          std::size_t alignment, class Lock,
+          template <std::size_t, typename, std::size_t> class Storage>
 inline std::basic_istream<element_t> &operator>>(
     std::basic_istream<element_t> &stream,
-    PcBuffer<depth, element_t, alignment, Lock> &instance)
+    PcBufferBase<T, depth, element_t, alignment, Lock, Storage> &instance)
 {
-    std::array<element_t, depth> elem_array;
-    instance.push_n_blocking(elem_array.data(),
-                             stream.readsome(elem_array.data(), depth));
+    auto segments = instance.reserve_write();
+
+    std::size_t count = 0;
+    for (auto segment : {segments.first, segments.second})
+    {
+        std::size_t read = stream.readsome(segment.data(), segment.size());
+        count += read;
+        if (read < segment.size())
+        {
+            break;
+        }
+    }
+
+    if (count)
+    {
+        instance.commit_write(count);
+    }
+
     return stream;
 }
 
-template <std::size_t depth, typename element_t = std::byte,
-          std::size_t alignment = sizeof(element_t), class Lock = NoopLock>
+template <class T, std::size_t depth, typename element_t,
+          std::size_t alignment, class Lock,
+          template <std::size_t, typename, std::size_t> class Storage>
 inline std::basic_ostream<element_t> &operator<<(
     std::basic_ostream<element_t> &stream,
-    PcBuffer<depth, element_t, alignment, Lock> &instance)
+    PcBufferBase<T, depth, element_t, alignment, Lock, Storage> &instance)
 {
-    std::array<element_t, depth> elem_array;
-    stream.write(elem_array.data(), instance.try_pop_n(elem_array));
+    auto segments = instance.peek_read();
+
+    if (not segments.empty())
+    {
+        stream.write(segments.first.data(), segments.first.size());
+        stream.write(segments.second.data(), segments.second.size());
+        instance.consume(segments.size());
+    }
+
     return stream;
 }
 
@@ -118,6 +118,27 @@ template <class T, typename element_t = std::byte> class PcBufferReader
         return static_cast<T *>(this)->try_pop_n_impl(elem_array, count);
     }
 
+    /**
+     * Read a single element from the buffer and block until it's available.
+     *
+     * \param[out] elem Same as \ref pop.
+     */
+    inline void pop_blocking(element_t &elem)
+    {
+        static_cast<T *>(this)->pop_blocking_impl(elem);
+    }
+
+    /**
+     * Read elements from the buffer and block until they've all been read.
+     *
+     * \param[out] elem_array Same as \ref pop_n.
+     * \param[in]  count      Same as \ref pop_n.
+     */
+    inline void pop_n_blocking(element_t *elem_array, std::size_t count)
+    {
+        static_cast<T *>(this)->pop_n_blocking_impl(elem_array, count);
+    }
+
     /**
      * Read all available elements from the buffer.
      *
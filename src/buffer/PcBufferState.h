@@ -5,16 +5,63 @@
 #pragma once
 
 /* toolchain */
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 
+/* internal */
+#include "../generated/structs/BufferMetrics.h"
+
 namespace Coral
 {
 
+/**
+ * A 64-bit statistics counter that other threads can read at any time
+ * (relaxed, so reads never stall the writer). Updates through the plain
+ * operators assume a single writer at a time, e.g. the buffer's lock holder.
+ */
+class BufferCounter
+{
+  public:
+    BufferCounter(uint64_t initial = 0) : value(initial)
+    {
+    }
+
+    inline operator uint64_t() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+
+    inline BufferCounter &operator=(uint64_t _value)
+    {
+        value.store(_value, std::memory_order_relaxed);
+        return *this;
+    }
+
+    inline BufferCounter &operator+=(uint64_t count)
+    {
+        return *this = *this + count;
+    }
+
+    inline BufferCounter &operator++(int)
+    {
+        return *this += 1;
+    }
+
+    /* Add from a context that isn't serialized with other writers. */
+    inline void add_concurrent(uint64_t count = 1)
+    {
+        value.fetch_add(count, std::memory_order_relaxed);
+    }
+
+  protected:
+    std::atomic<uint64_t> value;
+};
+
 struct PcBufferState
 {
-    PcBufferState(std::size_t _size)
-        : size(_size), data(0), space(_size), high_watermark(0),
-          write_dropped(0)
+    PcBufferState(std::size_t _size, std::size_t _element_size = 1)
+        : size(_size), element_size(_element_size), data(0), space(_size)
     {
     }
 
@@ -27,6 +74,15 @@ struct PcBufferState
         /* Reset stats. */
         high_watermark = 0;
         write_dropped = 0;
+        dropped_full = 0;
+        dropped_oversize = 0;
+        evicted = 0;
+        write_total = 0;
+        read_total = 0;
+        data_callbacks = 0;
+        space_callbacks = 0;
+        data_suppressed = 0;
+        space_suppressed = 0;
     }
 
     inline bool has_enough_space(std::size_t count)
@@ -46,15 +102,35 @@ struct PcBufferState
                 high_watermark = data;
             }
             space -= count;
+            write_total += count;
         }
         else if (drop)
         {
             write_dropped += count;
+            if (count > size)
+            {
+                dropped_oversize += count;
+            }
+            else
+            {
+                dropped_full += count;
+            }
         }
 
         return result;
     }
 
+    /*
+     * Discard the oldest count elements to make room for new ones (in
+     * overwrite mode, see \ref PcBufferBase::set_overwrite).
+     */
+    void evict(std::size_t count)
+    {
+        data -= count;
+        space += count;
+        evicted += count;
+    }
+
     inline bool has_enough_data(std::size_t count)
     {
         return data >= count;
@@ -68,12 +144,17 @@ struct PcBufferState
         {
             data -= count;
             space += count;
+            read_total += count;
         }
 
         return result;
     }
 
-    void poll_metrics(uint16_t &_high_watermark, uint16_t &_write_dropped,
+    /*
+     * Resetting also resets the drop causes, so that write_dropped stays
+     * their sum.
+     */
+    void poll_metrics(uint64_t &_high_watermark, uint64_t &_write_dropped,
                       bool reset = true)
     {
         _high_watermark = high_watermark;
@@ -82,9 +163,44 @@ struct PcBufferState
         {
             high_watermark = 0;
             write_dropped = 0;
+            dropped_full = 0;
+            dropped_oversize = 0;
         }
     }
 
+    /**
+     * Get a snapshot of buffer metrics (safe to call from any thread, and
+     * doesn't reset anything).
+     */
+    BufferMetrics metrics(void) const
+    {
+        BufferMetrics result = {};
+
+        result.timestamp_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        result.capacity = size;
+        result.element_size = element_size;
+
+        result.read_total = read_total;
+        result.write_total = write_total;
+        result.dropped_evicted = evicted;
+        result.data = result.write_total - result.read_total -
+                      result.dropped_evicted;
+        result.high_watermark = high_watermark;
+
+        result.dropped_full = dropped_full;
+        result.dropped_oversize = dropped_oversize;
+
+        result.data_callbacks = data_callbacks;
+        result.space_callbacks = space_callbacks;
+        result.data_suppressed = data_suppressed;
+        result.space_suppressed = space_suppressed;
+
+        return result;
+    }
+
     inline bool empty(void)
     {
         return data == 0;
@@ -106,12 +222,55 @@ struct PcBufferState
     }
 
     const std::size_t size;
+    const std::size_t element_size;
 
     std::size_t data;
     std::size_t space;
 
-    uint16_t high_watermark;
-    uint16_t write_dropped;
+    BufferCounter high_watermark;
+    BufferCounter write_dropped;
+
+    /* Dropped elements by cause (write_dropped is their sum). */
+    BufferCounter dropped_full;
+    BufferCounter dropped_oversize;
+
+    /* Unread elements overwritten by newer data (overwrite mode). */
+    BufferCounter evicted;
+
+    /* Elements written and read in total. */
+    BufferCounter write_total;
+    BufferCounter read_total;
+
+    /* Service callback invocations. */
+    BufferCounter data_callbacks;
+    BufferCounter space_callbacks;
+
+    /* Service callback invocations skipped by threshold coalescing. */
+    BufferCounter data_suppressed;
+    BufferCounter space_suppressed;
 };
 
+/**
+ * Compute the rate (in bytes per second) that data was written between two
+ * metrics snapshots of the same buffer.
+ */
+inline double write_rate(const BufferMetrics &earlier,
+                         const BufferMetrics &later)
+{
+    double seconds = (later.timestamp_ns - earlier.timestamp_ns) / 1e9;
+    return seconds > 0 ? (later.write_total - earlier.write_total) *
+                             later.element_size / seconds
+                       : 0.0;
+}
+
+/* Same as \ref write_rate but for data read. */
+inline double read_rate(const BufferMetrics &earlier,
+                        const BufferMetrics &later)
+{
+    double seconds = (later.timestamp_ns - earlier.timestamp_ns) / 1e9;
+    return seconds > 0 ? (later.read_total - earlier.read_total) *
+                             later.element_size / seconds
+                       : 0.0;
+}
+
 }; // namespace Coral
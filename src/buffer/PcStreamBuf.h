@@ -0,0 +1,192 @@
+/**
+ * \file
+ * \brief A standard stream buffer over a producer-consumer buffer.
+ */
+#pragma once
+
+/* toolchain */
+#include <cstdint>
+#include <ios>
+#include <streambuf>
+
+namespace Coral
+{
+
+/**
+ * Lets standard streams (e.g. std::istream, std::ostream, byte_istream and
+ * byte_ostream) read from and write to a producer-consumer buffer without
+ * intermediate arrays.
+ *
+ * The get and put areas are the buffer's contiguous readable and writable
+ * segments, used in place. Elements read through the get area are consumed,
+ * and elements written to the put area are published, on the next
+ * underflow/overflow, bulk transfer or sync (e.g. std::flush), and on
+ * destruction. Until then the stream buffer must be the buffer's only
+ * consumer (respectively producer).
+ *
+ * \tparam T         A \ref PcBufferBase implementation.
+ * \tparam element_t The kind of element the buffer stores.
+ */
+template <class T, typename element_t = typename T::Element>
+class PcStreamBuf : public std::basic_streambuf<element_t>
+{
+    using Base = std::basic_streambuf<element_t>;
+
+  public:
+    using typename Base::int_type;
+    using typename Base::traits_type;
+
+    /**
+     * \param[in] _buffer   Buffer to read from and write to.
+     * \param[in] _blocking Whether to wait for data (space) when the buffer
+     *                      is empty (full), rather than report end-of-file.
+     */
+    PcStreamBuf(T &_buffer, bool _blocking = false)
+        : Base(), buffer(_buffer), blocking(_blocking)
+    {
+    }
+
+    ~PcStreamBuf()
+    {
+        sync();
+    }
+
+    PcStreamBuf(const PcStreamBuf &) = delete;
+    PcStreamBuf &operator=(const PcStreamBuf &) = delete;
+
+  protected:
+    T &buffer;
+    bool blocking;
+
+    /* Consume whatever was read through the get area. */
+    inline void release_get(void)
+    {
+        if (this->gptr() != this->eback())
+        {
+            buffer.consume(this->gptr() - this->eback());
+        }
+        this->setg(nullptr, nullptr, nullptr);
+    }
+
+    /* Publish whatever was written through the put area. */
+    inline void commit_put(void)
+    {
+        if (this->pptr() != this->pbase())
+        {
+            buffer.commit_write(this->pptr() - this->pbase());
+        }
+        this->setp(nullptr, nullptr);
+    }
+
+    int_type underflow(void) override
+    {
+        release_get();
+
+        if (blocking)
+        {
+            buffer.wait_for_data();
+        }
+
+        auto segment = buffer.peek_read().first;
+        if (segment.empty())
+        {
+            return traits_type::eof();
+        }
+
+        /* The get area is never written through. */
+        auto base = const_cast<element_t *>(segment.data());
+        this->setg(base, base, base + segment.size());
+
+        return traits_type::to_int_type(*base);
+    }
+
+    int_type overflow(int_type elem = traits_type::eof()) override
+    {
+        commit_put();
+
+        if (blocking)
+        {
+            buffer.wait_for_space();
+        }
+
+        auto segment = buffer.reserve_write().first;
+        if (segment.empty())
+        {
+            return traits_type::eof();
+        }
+
+        this->setp(segment.data(), segment.data() + segment.size());
+
+        if (not traits_type::eq_int_type(elem, traits_type::eof()))
+        {
+            *this->pptr() = traits_type::to_char_type(elem);
+            this->pbump(1);
+        }
+
+        return traits_type::not_eof(elem);
+    }
+
+    /* Copy straight out of the ring (one copy per segment). */
+    std::streamsize xsgetn(element_t *elems, std::streamsize count) override
+    {
+        release_get();
+
+        std::streamsize total = 0;
+        while (total < count)
+        {
+            std::size_t popped =
+                buffer.try_pop_n(&elems[total], count - total);
+
+            if (popped == 0 and
+                (not blocking or not buffer.wait_for_data()))
+            {
+                break;
+            }
+
+            total += popped;
+        }
+
+        return total;
+    }
+
+    /* Copy straight into the ring (one copy per segment). */
+    std::streamsize xsputn(const element_t *elems,
+                           std::streamsize count) override
+    {
+        commit_put();
+
+        std::streamsize total = 0;
+        while (total < count)
+        {
+            std::size_t pushed =
+                buffer.try_push_n(&elems[total], count - total);
+
+            if (pushed == 0 and
+                (not blocking or not buffer.wait_for_space()))
+            {
+                break;
+            }
+
+            total += pushed;
+        }
+
+        return total;
+    }
+
+    std::streamsize showmanyc(void) override
+    {
+        release_get();
+
+        std::streamsize available = buffer.peek_read().size();
+        return available ? available : (blocking ? 0 : -1);
+    }
+
+    int sync(void) override
+    {
+        commit_put();
+        release_get();
+        return 0;
+    }
+};
+
+}; // namespace Coral
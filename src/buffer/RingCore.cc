@@ -0,0 +1,102 @@
+/* toolchain */
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+/* internal */
+#include "RingCore.h"
+
+namespace Coral
+{
+
+RingCore::RingCore(std::byte *_storage, std::size_t _capacity,
+                   std::size_t _element_size)
+    : storage(_storage), elements(_capacity), element_size(_element_size),
+      write_cursor(), read_cursor(), writes(0), reads(0)
+{
+    assert(storage and elements > 0 and element_size > 0);
+}
+
+void RingCore::advance(Cursor &cursor, std::size_t count)
+{
+    assert(count <= elements);
+
+    cursor.position += count;
+    cursor.index += count;
+    if (cursor.index >= elements)
+    {
+        cursor.index -= elements;
+    }
+}
+
+void RingCore::write(const void *src, std::size_t count)
+{
+    auto bytes = static_cast<const std::byte *>(src);
+
+    while (count)
+    {
+        std::size_t to_write = std::min(contiguous(write_index()), count);
+
+        if (bytes)
+        {
+            std::memcpy(at(write_index()), bytes, to_write * element_size);
+            bytes += to_write * element_size;
+        }
+
+        count -= to_write;
+        commit_write(to_write);
+    }
+}
+
+void RingCore::read(void *dst, std::size_t count)
+{
+    auto bytes = static_cast<std::byte *>(dst);
+
+    while (count)
+    {
+        std::size_t to_read = std::min(contiguous(read_index()), count);
+
+        if (bytes)
+        {
+            std::memcpy(bytes, at(read_index()), to_read * element_size);
+            bytes += to_read * element_size;
+        }
+
+        count -= to_read;
+        consume(to_read);
+    }
+}
+
+void RingCore::commit_write(std::size_t count)
+{
+    advance(write_cursor, count);
+    writes += count;
+}
+
+void RingCore::consume(std::size_t count)
+{
+    advance(read_cursor, count);
+    reads += count;
+}
+
+void RingCore::poll_metrics(uint32_t &_read_count, uint32_t &_write_count,
+                            bool reset)
+{
+    _read_count = reads;
+    _write_count = writes;
+    if (reset)
+    {
+        reads = 0;
+        writes = 0;
+    }
+}
+
+void RingCore::reset(void)
+{
+    write_cursor = {};
+    read_cursor = {};
+    writes = 0;
+    reads = 0;
+}
+
+}; // namespace Coral
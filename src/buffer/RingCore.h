@@ -0,0 +1,101 @@
+/**
+ * \file
+ * \brief Non-template cursor and copy logic for runtime-sized rings.
+ */
+#pragma once
+
+/* toolchain */
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace Coral
+{
+
+/* Depth value that selects a runtime-sized buffer (like std::span). */
+static constexpr std::size_t dynamic_depth = std::dynamic_extent;
+
+/**
+ * The cursor arithmetic and element copies behind every runtime-sized ring
+ * buffer, compiled once regardless of capacity or element type. Counts and
+ * indices are in elements, storage is untyped.
+ */
+class RingCore
+{
+  public:
+    RingCore(std::byte *_storage, std::size_t _capacity,
+             std::size_t _element_size);
+
+    inline std::size_t capacity(void) const
+    {
+        return elements;
+    }
+
+    inline std::size_t write_index(void) const
+    {
+        return write_cursor.index;
+    }
+
+    inline std::size_t read_index(void) const
+    {
+        return read_cursor.index;
+    }
+
+    inline uint64_t total_written(void) const
+    {
+        return write_cursor.position;
+    }
+
+    inline uint64_t total_read(void) const
+    {
+        return read_cursor.position;
+    }
+
+    inline std::byte *at(std::size_t index) const
+    {
+        return storage + index * element_size;
+    }
+
+    /* The number of elements accessible linearly from an index. */
+    inline std::size_t contiguous(std::size_t index) const
+    {
+        return elements - index;
+    }
+
+    /*
+     * Copy elements in or out at the cursors (a null pointer skips the
+     * copy), advancing them. The caller is responsible for there being
+     * enough space or data.
+     */
+    void write(const void *src, std::size_t count);
+    void read(void *dst, std::size_t count);
+
+    void commit_write(std::size_t count);
+    void consume(std::size_t count);
+
+    void poll_metrics(uint32_t &_read_count, uint32_t &_write_count,
+                      bool reset = true);
+
+    void reset(void);
+
+  protected:
+    struct Cursor
+    {
+        uint64_t position = 0;
+        std::size_t index = 0;
+    };
+
+    std::byte *const storage;
+    const std::size_t elements;
+    const std::size_t element_size;
+
+    Cursor write_cursor;
+    Cursor read_cursor;
+
+    uint32_t writes;
+    uint32_t reads;
+
+    void advance(Cursor &cursor, std::size_t count);
+};
+
+}; // namespace Coral
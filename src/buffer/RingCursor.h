@@ -0,0 +1,81 @@
+/**
+ * \file
+ * \brief A ring-buffer cursor with depth-specialised index arithmetic.
+ */
+#pragma once
+
+/* toolchain */
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+namespace Coral
+{
+
+/**
+ * A free-running (64-bit) ring-buffer position along with the buffer index
+ * it corresponds to.
+ *
+ * For power-of-two depths the index is the position masked. Otherwise the
+ * index is tracked alongside the position and wrapped with a branch, so
+ * neither shape divides on the hot path or reads the wrong slot when the
+ * position overflows a narrower type.
+ *
+ * \tparam depth The number of elements in the ring.
+ */
+template <std::size_t depth> class RingCursor
+{
+    static_assert(depth > 0);
+
+  public:
+    static constexpr bool power_of_two = std::has_single_bit(depth);
+
+    /* The buffer index of the current position. */
+    inline std::size_t index(void) const
+    {
+        if constexpr (power_of_two)
+        {
+            return position & (depth - 1);
+        }
+        else
+        {
+            return wrapped;
+        }
+    }
+
+    /* The total number of elements advanced over. */
+    inline uint64_t total(void) const
+    {
+        return position;
+    }
+
+    /* Advance by up to depth elements. */
+    inline void advance(std::size_t count)
+    {
+        assert(count <= depth);
+        position += count;
+
+        if constexpr (not power_of_two)
+        {
+            wrapped += count;
+            if (wrapped >= depth)
+            {
+                wrapped -= depth;
+            }
+        }
+    }
+
+    inline void reset(void)
+    {
+        position = 0;
+        wrapped = 0;
+    }
+
+  protected:
+    uint64_t position = 0;
+
+    /* Only maintained for depths that aren't a power of two. */
+    std::size_t wrapped = 0;
+};
+
+}; // namespace Coral
@@ -0,0 +1,167 @@
+/**
+ * \file
+ * \brief A view of a (possibly wrapped) region of a ring buffer.
+ */
+#pragma once
+
+/* toolchain */
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace Coral
+{
+
+/**
+ * Up to two contiguous spans that together cover a region of a circular
+ * buffer. The second span is only non-empty when the region wraps.
+ *
+ * \tparam element_t The kind of element the buffer stores.
+ */
+template <typename element_t> struct RingSegments
+{
+    using value_type = std::remove_cv_t<element_t>;
+
+    std::span<element_t> first;
+    std::span<element_t> second;
+
+    inline std::size_t size(void) const
+    {
+        return first.size() + second.size();
+    }
+
+    inline bool empty(void) const
+    {
+        return first.empty() and second.empty();
+    }
+
+    inline bool contiguous(void) const
+    {
+        return second.empty();
+    }
+
+    inline element_t &operator[](std::size_t index) const
+    {
+        return index < first.size() ? first[index]
+                                    : second[index - first.size()];
+    }
+
+    /* The count elements starting offset elements in. */
+    RingSegments subrange(std::size_t offset, std::size_t count) const
+    {
+        if (offset >= first.size())
+        {
+            return {second.subspan(offset - first.size(), count), {}};
+        }
+
+        std::size_t head = std::min(count, first.size() - offset);
+        return {first.subspan(offset, head), second.first(count - head)};
+    }
+
+    /**
+     * Find the first occurrence of an element (at or after \p start) across
+     * both spans, with memchr for byte-sized elements.
+     *
+     * \return Offset of the element, or \ref size if it isn't present.
+     */
+    std::size_t find(const value_type &elem, std::size_t start = 0) const
+    {
+        std::size_t offset = 0;
+
+        for (auto segment : {first, second})
+        {
+            if (start < segment.size())
+            {
+                std::size_t found =
+                    start + find_in(segment.subspan(start), elem);
+                if (found < segment.size())
+                {
+                    return offset + found;
+                }
+                start = 0;
+            }
+            else
+            {
+                start -= segment.size();
+            }
+
+            offset += segment.size();
+        }
+
+        return size();
+    }
+
+    /**
+     * Copy (up to \p count) elements out, starting \p offset elements in.
+     *
+     * \return The number of elements copied.
+     */
+    std::size_t copy_to(value_type *elem_array, std::size_t offset,
+                        std::size_t count) const
+    {
+        std::size_t copied = 0;
+
+        for (auto segment : {first, second})
+        {
+            if (offset < segment.size())
+            {
+                auto part =
+                    segment.subspan(offset).first(std::min(
+                        count - copied, segment.size() - offset));
+                std::copy(part.begin(), part.end(), &elem_array[copied]);
+                copied += part.size();
+                offset = 0;
+            }
+            else
+            {
+                offset -= segment.size();
+            }
+        }
+
+        return copied;
+    }
+
+    /**
+     * Copy (up to \p count) elements in, from the start of the region.
+     *
+     * \return The number of elements copied.
+     */
+    std::size_t copy_from(const value_type *elem_array, std::size_t count)
+        requires(not std::is_const_v<element_t>)
+    {
+        std::size_t copied = 0;
+
+        for (auto segment : {first, second})
+        {
+            std::size_t part = std::min(count - copied, segment.size());
+            std::copy_n(&elem_array[copied], part, segment.data());
+            copied += part;
+        }
+
+        return copied;
+    }
+
+  protected:
+    static std::size_t find_in(std::span<element_t> segment,
+                               const value_type &elem)
+    {
+        if constexpr (sizeof(value_type) == 1 and
+                      std::is_trivially_copyable_v<value_type>)
+        {
+            auto found = static_cast<const value_type *>(std::memchr(
+                segment.data(), std::bit_cast<unsigned char>(elem),
+                segment.size()));
+            return found ? found - segment.data() : segment.size();
+        }
+        else
+        {
+            return std::find(segment.begin(), segment.end(), elem) -
+                   segment.begin();
+        }
+    }
+};
+
+}; // namespace Coral
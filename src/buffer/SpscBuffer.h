@@ -0,0 +1,604 @@
+/**
+ * \file
+ * \brief A lock-free, single-producer single-consumer buffer implementation.
+ */
+#pragma once
+
+/* toolchain */
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+/* internal */
+#include "../Waiter.h"
+#include "../cache.h"
+#include "ArrayStorage.h"
+#include "PcBufferReader.h"
+#include "PcBufferWriter.h"
+#include "RingSegments.h"
+
+namespace Coral
+{
+
+/**
+ * A producer-consumer buffer that is safe to use from exactly one producer
+ * thread and one consumer thread without locking.
+ *
+ * Each side owns a free-running cursor (published with release semantics)
+ * on its own cache line, alongside a cached copy of the other side's cursor
+ * that is only refreshed (with acquire semantics) when the cached value
+ * suggests the buffer is full (producer) or empty (consumer).
+ *
+ * Blocking operations park the calling thread (see \ref Waiter) until the
+ * other side makes progress.
+ *
+ * In overwrite mode the producer never waits on (or even reads) the
+ * consumer's cursor, so a stalled consumer can't stall it: writes always
+ * succeed (up to the buffer depth) and the newest data wins. The producer
+ * announces how far it's about to write (the claimed cursor) before writing,
+ * and the consumer skips data that's been lapped and retries a copy the
+ * producer may have overwritten mid-way (as with a seqlock), counting the
+ * elements it loses as evicted. Elements are then accessed with relaxed
+ * atomics, and zero-copy access is unavailable.
+ *
+ * \tparam depth     The number of elements the buffer holds.
+ * \tparam element_t The kind of element the buffer stores.
+ * \tparam alignment Alignment of the underlying storage.
+ * \tparam Storage   Storage backend (see \ref ArrayStorage).
+ * \tparam overwrite Whether writes to a full buffer evict the oldest data.
+ */
+template <std::size_t depth, typename element_t = std::byte,
+          std::size_t alignment = sizeof(element_t),
+          template <std::size_t, typename, std::size_t> class Storage =
+              ArrayStorage,
+          bool overwrite = false>
+class SpscBuffer
+    : public PcBufferWriter<
+          SpscBuffer<depth, element_t, alignment, Storage, overwrite>,
+          element_t>,
+      public PcBufferReader<
+          SpscBuffer<depth, element_t, alignment, Storage, overwrite>,
+          element_t>
+{
+    static_assert(depth > 0);
+    static_assert(not overwrite or
+                  std::atomic_ref<element_t>::is_always_lock_free);
+
+  public:
+    static constexpr std::size_t Depth = depth;
+
+    static constexpr bool Mirrored =
+        Storage<depth, element_t, alignment>::mirrored;
+
+    SpscBuffer()
+        : producer(), consumer(), data_ready(), space_ready(), buffer()
+    {
+    }
+
+    /*
+     * Queries. Only exact from the side that owns the relevant cursor, a
+     * snapshot otherwise.
+     */
+
+    inline std::size_t data_available(void)
+    {
+        /* The producer may have lapped the consumer (overwrite mode). */
+        return std::min<std::size_t>(
+            producer.position.load(std::memory_order_acquire) -
+                consumer.position.load(std::memory_order_acquire),
+            depth);
+    }
+
+    inline std::size_t space_available(void)
+    {
+        return depth - data_available();
+    }
+
+    inline bool empty(void)
+    {
+        return data_available() == 0;
+    }
+
+    inline bool full(void)
+    {
+        return data_available() == depth;
+    }
+
+    inline uint64_t write_dropped(void)
+    {
+        return producer.dropped.load(std::memory_order_relaxed);
+    }
+
+    /* Elements the consumer lost to the producer lapping it. */
+    inline uint64_t evicted(void)
+    {
+        return consumer.evicted;
+    }
+
+    inline const element_t *head(void)
+    {
+        return buffer.data();
+    }
+
+    /*
+     * Producer interfaces.
+     */
+
+    Result push_impl(const element_t elem, bool drop = false)
+    {
+        return push_n_impl(&elem, 1, drop);
+    }
+
+    Result push_n_impl(const element_t *elem_array, std::size_t count,
+                       bool drop = false)
+    {
+        bool result = writable(count) >= count;
+
+        if (result)
+        {
+            auto position = producer.position.load(std::memory_order_relaxed);
+
+            if constexpr (overwrite)
+            {
+                /* Publish the claim before any element it overwrites. */
+                producer.claimed.store(position + count,
+                                       std::memory_order_release);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            copy_in(position, elem_array, count);
+            producer.position.store(position + count,
+                                    std::memory_order_release);
+            data_ready.notify();
+        }
+        else if (drop)
+        {
+            /* Only the producer writes it, but any thread may read it. */
+            producer.dropped.store(
+                producer.dropped.load(std::memory_order_relaxed) + count,
+                std::memory_order_relaxed);
+        }
+
+        return ToResult(result);
+    }
+
+    std::size_t try_push_n_impl(const element_t *elem_array, std::size_t count)
+    {
+        count = std::min(count, writable(count));
+
+        if (count)
+        {
+            push_n_impl(elem_array, count);
+        }
+
+        return count;
+    }
+
+    void push_blocking_impl(const element_t elem)
+    {
+        while (not ToBool(push_impl(elem)))
+        {
+            wait_for_space();
+        }
+    }
+
+    void push_n_blocking_impl(const element_t *elem_array, std::size_t count)
+    {
+        std::size_t pushed;
+        while (count)
+        {
+            pushed = try_push_n_impl(elem_array, count);
+            if (pushed)
+            {
+                if (elem_array)
+                {
+                    elem_array += pushed;
+                }
+                count -= pushed;
+            }
+            else
+            {
+                wait_for_space();
+            }
+        }
+    }
+
+    /**
+     * Block until at least \p count elements can be written (at most the
+     * buffer depth) or \p timeout elapses. Returns whether or not there's
+     * enough space.
+     */
+    bool wait_for_space(std::size_t count = 1,
+                        std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        count = std::min(count, depth);
+        return space_ready.wait(
+            [this, count]() { return writable(count) >= count; }, timeout);
+    }
+
+    RingSegments<element_t> reserve_write(std::size_t count = depth)
+        requires(not overwrite)
+    {
+        return segments<element_t>(
+            producer.position.load(std::memory_order_relaxed),
+            std::min(count, writable(count)));
+    }
+
+    Result commit_write(std::size_t count)
+        requires(not overwrite)
+    {
+        bool result = writable(count) >= count;
+
+        if (result)
+        {
+            producer.position.fetch_add(count, std::memory_order_release);
+            data_ready.notify();
+        }
+
+        return ToResult(result);
+    }
+
+    /*
+     * Consumer interfaces.
+     */
+
+    Result pop_impl(element_t &elem)
+    {
+        return pop_n_impl(&elem, 1);
+    }
+
+    Result pop_n_impl(element_t *elem_array, std::size_t count)
+    {
+        if constexpr (overwrite)
+        {
+            return ToResult(count <= depth and
+                            pop_lapped(elem_array, count, false) == count);
+        }
+
+        bool result = readable(count) >= count;
+
+        if (result)
+        {
+            auto position = consumer.position.load(std::memory_order_relaxed);
+            copy_out(position, elem_array, count);
+            consumer.position.store(position + count,
+                                    std::memory_order_release);
+            space_ready.notify();
+        }
+
+        return ToResult(result);
+    }
+
+    std::size_t try_pop_n_impl(element_t *elem_array, std::size_t count)
+    {
+        if constexpr (overwrite)
+        {
+            return pop_lapped(elem_array, count, true);
+        }
+
+        count = std::min(count, readable(count));
+
+        if (count)
+        {
+            pop_n_impl(elem_array, count);
+        }
+
+        return count;
+    }
+
+    std::size_t pop_all_impl(element_t *elem_array = nullptr)
+    {
+        return try_pop_n_impl(elem_array, readable(depth));
+    }
+
+    void pop_blocking_impl(element_t &elem)
+    {
+        while (not ToBool(pop_impl(elem)))
+        {
+            wait_for_data();
+        }
+    }
+
+    void pop_n_blocking_impl(element_t *elem_array, std::size_t count)
+    {
+        std::size_t popped;
+        while (count)
+        {
+            popped = try_pop_n_impl(elem_array, count);
+            if (popped)
+            {
+                if (elem_array)
+                {
+                    elem_array += popped;
+                }
+                count -= popped;
+            }
+            else
+            {
+                wait_for_data();
+            }
+        }
+    }
+
+    /**
+     * Block until at least \p count elements can be read (at most the buffer
+     * depth) or \p timeout elapses. Returns whether or not enough data is
+     * available.
+     */
+    bool wait_for_data(std::size_t count = 1,
+                       std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        count = std::min(count, depth);
+        return data_ready.wait(
+            [this, count]() { return readable(count) >= count; }, timeout);
+    }
+
+    inline element_t peek(void)
+        requires(not overwrite)
+    {
+        assert(readable(1));
+        auto position = consumer.position.load(std::memory_order_relaxed);
+        return buffer[index(position)];
+    }
+
+    RingSegments<const element_t> peek_read(std::size_t count = depth)
+        requires(not overwrite)
+    {
+        return segments<const element_t>(
+            consumer.position.load(std::memory_order_relaxed),
+            std::min(count, readable(count)));
+    }
+
+    Result consume(std::size_t count)
+        requires(not overwrite)
+    {
+        bool result = readable(count) >= count;
+
+        if (result)
+        {
+            consumer.position.fetch_add(count, std::memory_order_release);
+            space_ready.notify();
+        }
+
+        return ToResult(result);
+    }
+
+  protected:
+    /*
+     * Producer-owned state: the write cursor and the last observed read
+     * cursor.
+     */
+    struct alignas(cache_line_size) Producer
+    {
+        std::atomic<uint64_t> position = 0;
+        uint64_t cached = 0;
+        std::atomic<uint64_t> dropped = 0;
+
+        /* Where writing is about to reach (overwrite mode). */
+        std::atomic<uint64_t> claimed = 0;
+    };
+
+    /*
+     * Consumer-owned state: the read cursor and the last observed write
+     * cursor.
+     */
+    struct alignas(cache_line_size) Consumer
+    {
+        std::atomic<uint64_t> position = 0;
+        uint64_t cached = 0;
+        uint64_t evicted = 0;
+    };
+
+    Producer producer;
+    Consumer consumer;
+
+    /* Waited on by the consumer and producer respectively. */
+    alignas(cache_line_size) Waiter data_ready;
+    Waiter space_ready;
+
+    alignas(cache_line_size) Storage<depth, element_t, alignment> buffer;
+
+    /* Space available to the producer, refreshing the consumer's cursor only
+     * if \p wanted elements don't appear to fit. */
+    inline std::size_t writable(std::size_t wanted)
+    {
+        if constexpr (overwrite)
+        {
+            (void)wanted;
+            return depth;
+        }
+
+        auto position = producer.position.load(std::memory_order_relaxed);
+        std::size_t space = depth - (position - producer.cached);
+
+        if (space < wanted)
+        {
+            producer.cached =
+                consumer.position.load(std::memory_order_acquire);
+            space = depth - (position - producer.cached);
+        }
+
+        return space;
+    }
+
+    /* Data available to the consumer, refreshing the producer's cursor only
+     * if \p wanted elements don't appear to be present. */
+    inline std::size_t readable(std::size_t wanted)
+    {
+        auto position = consumer.position.load(std::memory_order_relaxed);
+        std::size_t data = consumer.cached - position;
+
+        if (data < wanted)
+        {
+            consumer.cached =
+                producer.position.load(std::memory_order_acquire);
+            data = consumer.cached - position;
+        }
+
+        return data;
+    }
+
+    static inline std::size_t index(uint64_t position)
+    {
+        return position % depth;
+    }
+
+    static constexpr std::size_t contiguous(std::size_t idx)
+    {
+        if constexpr (Mirrored)
+        {
+            (void)idx;
+            return depth;
+        }
+        else
+        {
+            return depth - idx;
+        }
+    }
+
+    template <typename T>
+    inline RingSegments<T> segments(uint64_t position, std::size_t count)
+    {
+        std::size_t idx = index(position);
+        std::size_t first = std::min(contiguous(idx), count);
+        T *base = buffer.data();
+
+        return {std::span<T>(&base[idx], first),
+                std::span<T>(base, count - first)};
+    }
+
+    inline void copy_in(uint64_t position, const element_t *elem_array,
+                        std::size_t count)
+    {
+        if (elem_array)
+        {
+            auto region = segments<element_t>(position, count);
+
+            if constexpr (overwrite)
+            {
+                /* The consumer may be reading these concurrently. */
+                for (auto &elem : region.first)
+                {
+                    std::atomic_ref(elem).store(*elem_array++,
+                                                std::memory_order_relaxed);
+                }
+                for (auto &elem : region.second)
+                {
+                    std::atomic_ref(elem).store(*elem_array++,
+                                                std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                std::memcpy(region.first.data(), elem_array,
+                            region.first.size_bytes());
+                std::memcpy(region.second.data(),
+                            elem_array + region.first.size(),
+                            region.second.size_bytes());
+            }
+        }
+    }
+
+    inline void copy_out(uint64_t position, element_t *elem_array,
+                         std::size_t count)
+    {
+        if (elem_array)
+        {
+            if constexpr (overwrite)
+            {
+                /* The producer may be overwriting these concurrently. */
+                auto region = segments<element_t>(position, count);
+                for (auto &elem : region.first)
+                {
+                    *elem_array++ =
+                        std::atomic_ref(elem).load(std::memory_order_relaxed);
+                }
+                for (auto &elem : region.second)
+                {
+                    *elem_array++ =
+                        std::atomic_ref(elem).load(std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                auto region = segments<const element_t>(position, count);
+                std::memcpy(elem_array, region.first.data(),
+                            region.first.size_bytes());
+                std::memcpy(elem_array + region.first.size(),
+                            region.second.data(), region.second.size_bytes());
+            }
+        }
+    }
+
+    /*
+     * Pop (overwrite mode): skip past anything the producer has lapped,
+     * copy, then check that the producer didn't claim any of the copied
+     * elements in the meantime (retrying if it did). Pops exactly count
+     * elements, or (if partial) as many as are available up to count.
+     */
+    std::size_t pop_lapped(element_t *elem_array, std::size_t count,
+                           bool partial)
+    {
+        auto position = consumer.position.load(std::memory_order_relaxed);
+        std::size_t popped = 0;
+
+        count = std::min(count, depth);
+        while (count)
+        {
+            /*
+             * Load the claim before the write cursor, so that the cursor is
+             * no more than a depth behind it (the claim is released after
+             * the previous write was published).
+             */
+            uint64_t claimed =
+                producer.claimed.load(std::memory_order_acquire);
+            uint64_t written =
+                producer.position.load(std::memory_order_acquire);
+            consumer.cached = written;
+
+            /* Anything older than a depth behind the claim is lost. */
+            if (claimed > position + depth)
+            {
+                consumer.evicted += claimed - depth - position;
+                position = claimed - depth;
+            }
+
+            /* Never read (or move the read cursor) past the write cursor. */
+            if (position > written)
+            {
+                continue;
+            }
+
+            std::size_t available = written - position;
+            std::size_t wanted = partial ? std::min(count, available) : count;
+            if (wanted == 0 or wanted > available)
+            {
+                break;
+            }
+
+            copy_out(position, elem_array, wanted);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (producer.claimed.load(std::memory_order_relaxed) <=
+                position + depth)
+            {
+                position += wanted;
+                popped = wanted;
+                break;
+            }
+        }
+
+        consumer.position.store(position, std::memory_order_release);
+
+        if (popped)
+        {
+            space_ready.notify();
+        }
+
+        return popped;
+    }
+};
+
+}; // namespace Coral
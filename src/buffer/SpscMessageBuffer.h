@@ -0,0 +1,501 @@
+/**
+ * \file
+ * \brief A lock-free, single-producer single-consumer message buffer.
+ */
+#pragma once
+
+/* toolchain */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+
+/* internal */
+#include "../Waiter.h"
+#include "../cache.h"
+#include "../generated/ifgen/common.h"
+#include "../logging/LogInterface.h"
+#include "../result.h"
+#include "ArrayStorage.h"
+#include "RingSegments.h"
+#include "message_encoding.h"
+
+namespace Coral
+{
+
+/**
+ * A message buffer that is safe to use from exactly one producer thread and
+ * one consumer thread without locking (e.g. so that messages can be encoded
+ * and sent by a thread other than the one generating them).
+ *
+ * Messages are stored inline, each behind a varint length header (see
+ * \ref MessageBuffer). The producer writes a message through a
+ * \ref MessageContext into free space, then publishes it (header and all)
+ * by advancing its cursor with release semantics when the context closes.
+ * A message that doesn't fit, or whose context is aborted, is simply never
+ * published.
+ *
+ * The consumer claims messages (acquiring the producer's cursor) and reads
+ * them in place, then releases them (publishing its own cursor with release
+ * semantics) to free their space. The producer keeps appending while
+ * messages are claimed, since it only writes past the consumer's cursor.
+ *
+ * As with \ref SpscBuffer, each side keeps a cached copy of the other's
+ * cursor on its own cache line, only refreshing it when it appears to be
+ * out of space (producer) or messages (consumer).
+ *
+ * \tparam depth     The number of elements the buffer holds.
+ * \tparam element_t The kind of element the buffer stores.
+ * \tparam alignment Alignment of the underlying storage.
+ * \tparam Storage   Storage backend (see \ref ArrayStorage).
+ */
+template <std::size_t depth, byte_size element_t = std::byte,
+          std::size_t alignment = sizeof(element_t),
+          template <std::size_t, typename, std::size_t> class Storage =
+              ArrayStorage>
+class SpscMessageBuffer
+{
+    static_assert(depth > 0);
+
+  public:
+    static constexpr std::size_t Depth = depth;
+
+    static constexpr bool Mirrored =
+        Storage<depth, element_t, alignment>::mirrored;
+
+    /* Contexts reserve a header that fits any length (see encode_varint). */
+    static constexpr std::size_t max_header = varint_size(depth);
+
+    /*
+     * A message being written (by the producer). Writes are checked against
+     * the free space first, and if one doesn't fit the message is rejected
+     * (when the context closes) instead.
+     */
+    class MessageContext : public Coral::LogInterface<MessageContext>
+    {
+      public:
+        MessageContext(SpscMessageBuffer *_buf)
+            : buf(_buf),
+              start(_buf->producer.position.load(std::memory_order_relaxed)),
+              len(0), aborted(false), overflow(false)
+        {
+        }
+
+        MessageContext(const MessageContext &) = delete;
+        MessageContext &operator=(const MessageContext &) = delete;
+
+        ~MessageContext()
+        {
+            if (aborted or not admit(0))
+            {
+                /* Only the producer writes it, but any thread may read it. */
+                auto &rejected = buf->producer.rejected;
+                rejected.store(rejected.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_relaxed);
+            }
+            else
+            {
+                auto header = encode_varint<element_t, max_header>(len, true);
+                buf->copy_in(start, header.data(), max_header);
+                buf->publish(start + max_header + len);
+            }
+        }
+
+        /* Discard the message (when the context closes). */
+        inline void abort(void)
+        {
+            aborted = true;
+        }
+
+        /* Elements the message can still grow by. */
+        inline std::size_t remaining(void)
+        {
+            std::size_t used = max_header + len;
+            std::size_t space = buf->writable(depth);
+            return (not overflow and space > used) ? space - used : 0;
+        }
+
+        /* Whether or not a write didn't fit (rejecting the message). */
+        inline bool overflowed(void)
+        {
+            return overflow;
+        }
+
+        inline std::size_t write_n(const element_t *elem_array,
+                                   std::size_t count)
+        {
+            if (not admit(count))
+            {
+                return 0;
+            }
+
+            buf->copy_in(start + max_header + len, elem_array, count);
+            len += count;
+            return count;
+        }
+
+        template <std::endian endianness, typename T>
+        inline std::size_t write(T elem)
+            requires(not std::is_pointer_v<T>)
+        {
+            /* Parameter passed by value can be directly swapped. */
+            elem = handle_endian<endianness>(elem);
+            return write_n(reinterpret_cast<const element_t *>(&elem),
+                           sizeof(T));
+        }
+
+        template <std::endian endianness, ifgen_struct T>
+        inline std::size_t write(const T *elem)
+        {
+            /* Use a stack instance/copy for byte swapping. */
+            T temp = T();
+            temp.template decode<endianness>(elem->raw_ro());
+            return write_n(reinterpret_cast<const element_t *>(temp.raw_ro()),
+                           T::size);
+        }
+
+        template <std::endian endianness, ifgen_struct T>
+        inline std::size_t point(const T *elem)
+        {
+            std::size_t result = write<endianness>(T::id);
+            return result + write<endianness>(elem);
+        }
+
+        /*
+         * Get the region the message's next (up to) count elements would
+         * occupy, to populate in place before committing them.
+         */
+        inline RingSegments<element_t> reserve_write(std::size_t count)
+        {
+            return buf->template segments<element_t>(
+                start + max_header + len, std::min(count, remaining()));
+        }
+
+        inline void commit_write(std::size_t count)
+        {
+            if (admit(count))
+            {
+                len += count;
+            }
+        }
+
+        /* Format into the message, truncated to the free space. */
+        void vlog_impl(const char *fmt, va_list args)
+        {
+            std::size_t n = vformat_segments(reserve_write(depth), fmt, args);
+            if (n)
+            {
+                commit_write(n);
+            }
+        }
+
+      protected:
+        SpscMessageBuffer *buf;
+
+        /* Where the message (its header) starts. */
+        const uint64_t start;
+        std::size_t len;
+
+        bool aborted;
+        bool overflow;
+
+        /* Whether or not count more elements fit. */
+        inline bool admit(std::size_t count)
+        {
+            std::size_t wanted = max_header + len + count;
+            if (not overflow and buf->writable(wanted) < wanted)
+            {
+                overflow = true;
+            }
+
+            return not overflow;
+        }
+    };
+
+    SpscMessageBuffer()
+        : producer(), consumer(), data_ready(), space_ready(), buffer()
+    {
+    }
+
+    /*
+     * Queries. Only exact from the side that owns the relevant cursor, a
+     * snapshot otherwise.
+     */
+
+    /* Elements in use (by published messages that aren't released). */
+    inline std::size_t data_available(void)
+    {
+        return producer.position.load(std::memory_order_acquire) -
+               consumer.position.load(std::memory_order_acquire);
+    }
+
+    inline std::size_t space_available(void)
+    {
+        return depth - data_available();
+    }
+
+    inline bool empty(void)
+    {
+        return data_available() == 0;
+    }
+
+    /* The number of context messages rejected (overflowed or aborted). */
+    inline uint64_t rejected(void)
+    {
+        return producer.rejected.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Producer interfaces.
+     */
+
+    MessageContext context(void)
+    {
+        return MessageContext(this);
+    }
+
+    Result put_message(const element_t *data, std::size_t len)
+    {
+        std::size_t header = varint_size(len);
+        bool result = writable(header + len) >= header + len;
+
+        if (result)
+        {
+            auto position = producer.position.load(std::memory_order_relaxed);
+            copy_in(position,
+                    encode_varint<element_t, max_header>(len, false).data(),
+                    header);
+            copy_in(position + header, data, len);
+            publish(position + header + len);
+        }
+
+        return ToResult(result);
+    }
+
+    /**
+     * Block until a message of \p len elements fits (from a context) or
+     * \p timeout elapses. Returns whether or not there's enough space.
+     */
+    bool wait_for_space(std::size_t len = 0,
+                        std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        std::size_t wanted = std::min(max_header + len, depth);
+        return space_ready.wait(
+            [this, wanted]() { return writable(wanted) >= wanted; },
+            timeout);
+    }
+
+    /*
+     * Consumer interfaces.
+     */
+
+    /**
+     * Claim the oldest unclaimed message, which can be read in place until
+     * it's released (see \ref release).
+     *
+     * \param[out] message The message's elements.
+     * \return             Whether or not there was a message to claim.
+     */
+    Result claim(RingSegments<const element_t> &message)
+    {
+        bool result = readable();
+
+        if (result)
+        {
+            std::size_t len = parse_header(consumer.claimed);
+            message = segments<const element_t>(consumer.claimed, len);
+            consumer.claimed += len;
+            consumer.outstanding++;
+        }
+
+        return ToResult(result);
+    }
+
+    /* The number of claimed messages that haven't been released. */
+    inline std::size_t claimed(void) const
+    {
+        return consumer.outstanding;
+    }
+
+    /*
+     * Release the \p count oldest claimed messages (freeing their space).
+     * Returns whether or not that many were claimed.
+     */
+    Result release(std::size_t count = 1)
+    {
+        bool result = count <= consumer.outstanding;
+
+        if (result and count)
+        {
+            auto position = consumer.position.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                position += parse_header(position);
+            }
+            consumer.outstanding -= count;
+
+            consumer.position.store(position, std::memory_order_release);
+            space_ready.notify();
+        }
+
+        return ToResult(result);
+    }
+
+    /*
+     * Claim, copy out and release the oldest message (failing while any are
+     * claimed, since the oldest is then already held).
+     */
+    Result get_message(element_t *data, std::size_t &len)
+    {
+        RingSegments<const element_t> message;
+        bool result = consumer.outstanding == 0 and ToBool(claim(message));
+
+        if (result)
+        {
+            len = message.size();
+            std::memcpy(data, message.first.data(),
+                        message.first.size_bytes());
+            std::memcpy(data + message.first.size(), message.second.data(),
+                        message.second.size_bytes());
+            release();
+        }
+
+        return ToResult(result);
+    }
+
+    /**
+     * Block until a message can be claimed or \p timeout elapses. Returns
+     * whether or not one can.
+     */
+    bool wait_for_message(std::chrono::nanoseconds timeout = Waiter::forever)
+    {
+        return data_ready.wait([this]() { return readable(); }, timeout);
+    }
+
+  protected:
+    /*
+     * Producer-owned state: the write cursor (the end of the newest
+     * published message) and the last observed read cursor.
+     */
+    struct alignas(cache_line_size) Producer
+    {
+        std::atomic<uint64_t> position = 0;
+        uint64_t cached = 0;
+        std::atomic<uint64_t> rejected = 0;
+    };
+
+    /*
+     * Consumer-owned state: the read cursor (the start of the oldest
+     * unreleased message), the last observed write cursor and the end of
+     * the newest claimed message.
+     */
+    struct alignas(cache_line_size) Consumer
+    {
+        std::atomic<uint64_t> position = 0;
+        uint64_t cached = 0;
+        uint64_t claimed = 0;
+        std::size_t outstanding = 0;
+    };
+
+    Producer producer;
+    Consumer consumer;
+
+    /* Waited on by the consumer and producer respectively. */
+    alignas(cache_line_size) Waiter data_ready;
+    Waiter space_ready;
+
+    alignas(cache_line_size) Storage<depth, element_t, alignment> buffer;
+
+    /* Space available to the producer, refreshing the consumer's cursor only
+     * if \p wanted elements don't appear to fit. */
+    inline std::size_t writable(std::size_t wanted)
+    {
+        auto position = producer.position.load(std::memory_order_relaxed);
+        std::size_t space = depth - (position - producer.cached);
+
+        if (space < wanted)
+        {
+            producer.cached =
+                consumer.position.load(std::memory_order_acquire);
+            space = depth - (position - producer.cached);
+        }
+
+        return space;
+    }
+
+    /* Whether or not the consumer has a message to claim, refreshing the
+     * producer's cursor only if it doesn't appear to. */
+    inline bool readable(void)
+    {
+        if (consumer.claimed == consumer.cached)
+        {
+            consumer.cached =
+                producer.position.load(std::memory_order_acquire);
+        }
+
+        return consumer.claimed != consumer.cached;
+    }
+
+    /* Make messages written up to position available to the consumer. */
+    inline void publish(uint64_t position)
+    {
+        producer.position.store(position, std::memory_order_release);
+        data_ready.notify();
+    }
+
+    /* Decode the length header at position (and advance past it). */
+    inline std::size_t parse_header(uint64_t &position)
+    {
+        std::size_t header = 0;
+        std::size_t len = decode_varint(
+            segments<const element_t>(position, max_header), header);
+        position += header;
+        return len;
+    }
+
+    static inline std::size_t index(uint64_t position)
+    {
+        return position % depth;
+    }
+
+    static constexpr std::size_t contiguous(std::size_t idx)
+    {
+        if constexpr (Mirrored)
+        {
+            (void)idx;
+            return depth;
+        }
+        else
+        {
+            return depth - idx;
+        }
+    }
+
+    template <typename T>
+    inline RingSegments<T> segments(uint64_t position, std::size_t count)
+    {
+        std::size_t idx = index(position);
+        std::size_t first = std::min(contiguous(idx), count);
+        T *base = buffer.data();
+
+        return {std::span<T>(&base[idx], first),
+                std::span<T>(base, count - first)};
+    }
+
+    inline void copy_in(uint64_t position, const element_t *elem_array,
+                        std::size_t count)
+    {
+        if (elem_array)
+        {
+            auto region = segments<element_t>(position, count);
+            std::memcpy(region.first.data(), elem_array,
+                        region.first.size_bytes());
+            std::memcpy(region.second.data(),
+                        elem_array + region.first.size(),
+                        region.second.size_bytes());
+        }
+    }
+};
+
+}; // namespace Coral
@@ -1,6 +1,9 @@
 #pragma once
 
 /* toolchain */
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <functional>
 #include <limits>
 
@@ -17,6 +20,9 @@ class MessageDecoder
   public:
     using Array = std::array<element_t, message_mtu>;
 
+    /* Elements taken from a reader at a time (see dispatch). */
+    static constexpr std::size_t dispatch_chunk = 64;
+
     /*
      * A callback prototype for handling fully decoded messages.
      */
@@ -37,15 +43,54 @@ class MessageDecoder
 
     template <class T> void dispatch(PcBufferReader<T, element_t> &reader)
     {
-        element_t current;
-        bool can_continue;
+        std::array<element_t, dispatch_chunk> chunk;
+        std::size_t count;
 
         /*
          * There's only as much work to do as there is data ready to be read
-         * from the buffer.
+         * from the buffer (taken a chunk at a time).
          */
-        while ((can_continue = ToBool(reader.pop(current))))
+        while ((count = reader.try_pop_n(chunk.data(), chunk.size())))
+        {
+            decode(chunk.data(), count);
+        }
+    }
+
+    /*
+     * Decode encoded data, servicing the message callback for each message
+     * completed.
+     */
+    void decode(const element_t *data, std::size_t count)
+    {
+        const element_t *end = data + count;
+
+        while (data < end)
         {
+            /*
+             * Take the data bytes before the next zero pointer as a run,
+             * stopping short at a zero (which ends the message early).
+             */
+            if (zero_pointer)
+            {
+                std::size_t run =
+                    std::min<std::size_t>(zero_pointer, end - data);
+                if (auto zero = std::memchr(data, 0, run))
+                {
+                    run = static_cast<const element_t *>(zero) - data;
+                }
+
+                add_run(data, run);
+                zero_pointer -= run;
+                data += run;
+
+                if (data == end)
+                {
+                    break;
+                }
+            }
+
+            element_t current = *data++;
+
             /*
              * If we expect zero and land on one. The current message is fully
              * decoded. Service the message callback, which will also reset
@@ -68,9 +113,10 @@ class MessageDecoder
 
             /*
              * Decode a zero, and refill the zero pointer with the current
-             * value.
+             * value (runs end on a zero or a zero pointer, so that's the
+             * only other case).
              */
-            else if (zero_pointer == 0)
+            else
             {
                 /*
                  * If we're expecting an overhead pointer, don't add a data
@@ -94,13 +140,6 @@ class MessageDecoder
                 /* Count the current byte we just read. */
                 zero_pointer = current - 1;
             }
-
-            /* Regular data byte. */
-            else
-            {
-                add_to_message(current);
-                zero_pointer--;
-            }
         }
     }
 
@@ -179,6 +218,24 @@ class MessageDecoder
         stats_new = true;
     }
 
+    void add_run(const element_t *data, std::size_t count)
+    {
+        /* Copy the run in one go, unless it reaches the MTU. */
+        if (not message_breached_mtu and message_index + count <= message_mtu)
+        {
+            std::copy_n(data, count, &message[message_index]);
+            message_index += count;
+            stats_new = stats_new or count;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                add_to_message(data[i]);
+            }
+        }
+    }
+
     void add_to_message(element_t value)
     {
         /* Discard all current data if we hit the MTU ceiling. */
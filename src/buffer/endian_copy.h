@@ -0,0 +1,141 @@
+/**
+ * \file
+ * \brief Bulk copies with byte-order conversion.
+ */
+#pragma once
+
+/* toolchain */
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Coral
+{
+
+/* Scalar types that can be copied (and converted) in bulk. */
+template <typename T>
+concept endian_scalar = (std::is_arithmetic_v<T> or std::is_enum_v<T>) and
+                        (sizeof(T) == 1 or sizeof(T) == 2 or
+                         sizeof(T) == 4 or sizeof(T) == 8);
+
+template <std::size_t size> struct swap_word;
+template <> struct swap_word<2>
+{
+    using type = uint16_t;
+};
+template <> struct swap_word<4>
+{
+    using type = uint32_t;
+};
+template <> struct swap_word<8>
+{
+    using type = uint64_t;
+};
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+/* A (per 128-bit lane) shuffle control that reverses each size-byte word. */
+template <std::size_t size, std::size_t width>
+inline constexpr std::array<int8_t, width> swap_mask = []() {
+    std::array<int8_t, width> result = {};
+    for (std::size_t i = 0; i < width; i++)
+    {
+        std::size_t lane = i % 16;
+        result[i] = static_cast<int8_t>((lane / size) * size +
+                                        (size - 1 - lane % size));
+    }
+    return result;
+}();
+#endif
+
+/**
+ * Copy \p count words of \p size bytes, reversing the bytes of each. The
+ * bulk of the copy uses the widest byte-shuffle available at compile time
+ * (AVX2, SSSE3 or NEON), the remainder is swapped one word at a time.
+ */
+template <std::size_t size>
+inline void swap_copy(void *dst, const void *src, std::size_t count)
+{
+    using word_t = typename swap_word<size>::type;
+
+    auto out = static_cast<uint8_t *>(dst);
+    auto in = static_cast<const uint8_t *>(src);
+    std::size_t bytes = count * size;
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i mask256 = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(swap_mask<size, 32>.data()));
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m256i data =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                            _mm256_shuffle_epi8(data, mask256));
+    }
+#endif
+
+#if defined(__SSSE3__)
+    const __m128i mask128 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(swap_mask<size, 16>.data()));
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i data =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                         _mm_shuffle_epi8(data, mask128));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= bytes; i += 16)
+    {
+        uint8x16_t data = vld1q_u8(in + i);
+        if constexpr (size == 2)
+        {
+            data = vrev16q_u8(data);
+        }
+        else if constexpr (size == 4)
+        {
+            data = vrev32q_u8(data);
+        }
+        else
+        {
+            data = vrev64q_u8(data);
+        }
+        vst1q_u8(out + i, data);
+    }
+#endif
+
+    for (; i < bytes; i += size)
+    {
+        word_t word;
+        std::memcpy(&word, in + i, size);
+        word = std::byteswap(word);
+        std::memcpy(out + i, &word, size);
+    }
+}
+
+/**
+ * Copy \p count values of type \p T between native representation and
+ * \p endianness (the conversion is symmetric).
+ */
+template <std::endian endianness, endian_scalar T>
+inline void endian_copy(void *dst, const void *src, std::size_t count)
+{
+    if constexpr (endianness == std::endian::native or sizeof(T) == 1)
+    {
+        std::memcpy(dst, src, count * sizeof(T));
+    }
+    else
+    {
+        swap_copy<sizeof(T)>(dst, src, count);
+    }
+}
+
+}; // namespace Coral
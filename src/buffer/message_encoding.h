@@ -0,0 +1,165 @@
+/**
+ * \file
+ * \brief Encoding helpers shared by the message buffers.
+ */
+#pragma once
+
+/* toolchain */
+#include <algorithm>
+#include <array>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+/* internal */
+#include "../generated/ifgen/common.h"
+#include "RingSegments.h"
+
+namespace Coral
+{
+
+/* The number of elements len takes as an (unsigned LEB128) varint. */
+constexpr std::size_t varint_size(std::size_t len)
+{
+    std::size_t result = 1;
+    while (len >>= 7)
+    {
+        result++;
+    }
+    return result;
+}
+
+/*
+ * Encode a length as a varint, in varint_size(len) elements or, if padded,
+ * all width elements (with redundant continuation bytes, so that a header
+ * can be reserved before the length is known).
+ */
+template <byte_size element_t, std::size_t width>
+std::array<element_t, width> encode_varint(std::size_t len, bool padded)
+{
+    std::array<element_t, width> result = {};
+    std::size_t size = padded ? width : varint_size(len);
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+        uint8_t byte = len & 0x7f;
+        len >>= 7;
+        if (i + 1 < size)
+        {
+            byte |= 0x80;
+        }
+        result[i] = static_cast<element_t>(byte);
+    }
+
+    return result;
+}
+
+/* Decode a varint at offset into a ring region (advancing past it). */
+template <typename element_t>
+std::size_t decode_varint(const RingSegments<element_t> &region,
+                          std::size_t &offset)
+{
+    std::size_t len = 0;
+    std::size_t shift = 0;
+    uint8_t byte;
+
+    do
+    {
+        byte = static_cast<uint8_t>(region[offset++]);
+        len |= std::size_t(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return len;
+}
+
+/* The most formatted output split across a wrapped region in one go. */
+static constexpr std::size_t wrap_scratch_size = 256;
+
+/*
+ * Place n elements of formatted output across both ends of a wrapped region
+ * (the tail already holds the start of it), truncating to the longest run
+ * that the head or a small scratch array can format contiguously. Kept out
+ * of line so that output which doesn't wrap doesn't pay for the scratch.
+ */
+[[gnu::noinline, gnu::cold]] inline std::size_t vformat_wrapped(
+    char *tail, std::size_t tail_size, char *head, std::size_t head_size,
+    std::size_t n, const char *fmt, va_list args)
+{
+    char scratch[wrap_scratch_size];
+
+    if (head_size > n or
+        (head_size > sizeof(scratch) and head_size > tail_size))
+    {
+        /* Format into the head, then move the rest into place. */
+        n = std::min(n, head_size - 1);
+        vsnprintf(head, head_size, fmt, args);
+        tail[tail_size - 1] = head[tail_size - 1];
+        std::memmove(head, head + tail_size, n - tail_size);
+    }
+    else if (sizeof(scratch) > tail_size)
+    {
+        n = std::min(n, sizeof(scratch) - 1);
+        vsnprintf(scratch, sizeof(scratch), fmt, args);
+        tail[tail_size - 1] = scratch[tail_size - 1];
+        std::memcpy(head, scratch + tail_size, n - tail_size);
+    }
+    else
+    {
+        /* The (terminated) tail is as much as fits. */
+        n = tail_size - 1;
+    }
+
+    return n;
+}
+
+/**
+ * Format into a ring region, truncated to fit, and terminated if there's
+ * room. Output that wraps is split across both ends (see vformat_wrapped).
+ *
+ * \return The number of elements formatted (excluding the terminator).
+ */
+template <byte_size element_t>
+std::size_t vformat_segments(RingSegments<element_t> region, const char *fmt,
+                             va_list args)
+{
+    auto tail = reinterpret_cast<char *>(region.first.data());
+    std::size_t tail_size = region.first.size();
+    std::size_t head_size = region.second.size();
+
+    if (tail_size == 0)
+    {
+        return 0;
+    }
+
+    va_list tail_args;
+    va_copy(tail_args, args);
+    int result = vsnprintf(tail, tail_size, fmt, tail_args);
+    va_end(tail_args);
+
+    if (result <= 0)
+    {
+        return 0;
+    }
+
+    std::size_t n = result;
+    if (n >= tail_size)
+    {
+        if (head_size == 0)
+        {
+            n = tail_size - 1;
+        }
+        else
+        {
+            n = vformat_wrapped(tail, tail_size,
+                                reinterpret_cast<char *>(region.second.data()),
+                                head_size, std::min(n, region.size()), fmt,
+                                args);
+        }
+    }
+
+    return n;
+}
+
+}; // namespace Coral
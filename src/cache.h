@@ -0,0 +1,25 @@
+/**
+ * \file
+ * \brief Cache-geometry constants.
+ */
+#pragma once
+
+/* toolchain */
+#include <cstdint>
+
+namespace Coral
+{
+
+/*
+ * Granularity used to keep independently written data (e.g. producer and
+ * consumer cursors) from sharing a cache line. Fixed rather than taken from
+ * std::hardware_destructive_interference_size so that layouts don't depend
+ * on compiler tuning flags.
+ */
+#ifndef CORAL_CACHE_LINE_SIZE
+#define CORAL_CACHE_LINE_SIZE 64
+#endif
+
+static constexpr std::size_t cache_line_size = CORAL_CACHE_LINE_SIZE;
+
+}; // namespace Coral
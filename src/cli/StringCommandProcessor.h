@@ -67,29 +67,36 @@ class StringCommandProcessor
 
         while (not input.empty())
         {
-            input.pop_n(&line[index], 1);
+            /* Take up to a line (or whatever of one has arrived) at once. */
+            std::size_t popped =
+                input.pop_until(line_delim, &line[index], depth - 1 - index);
+            if (not popped)
+            {
+                break;
+            }
+            index += popped;
 
-            if (line[index] != line_delim)
+            if (line[index - 1] == line_delim)
             {
-                index++;
+                index--;
 
-                /*
-                 * Drop the current buffer if it becomes full before we see
-                 * the delimeter.
-                 */
-                if (index >= depth - 1)
+                /* Only take action if we have some input. */
+                if (index)
                 {
-                    reset();
+                    line[index] = null;
+                    process(line, index);
+                    num_lines++;
                 }
+                reset();
             }
 
-            /* Only take action if we have some input. */
-            else if (index)
+            /*
+             * Drop the current buffer if it becomes full before we see the
+             * delimeter.
+             */
+            else if (index >= depth - 1)
             {
-                line[index] = null;
-                process(line, index);
                 reset();
-                num_lines++;
             }
         }
 
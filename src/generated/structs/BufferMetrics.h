@@ -0,0 +1,144 @@
+/**
+ * \file
+ * \brief Generated by ifgen (4.8.0).
+ */
+
+#pragma once
+#ifndef CORAL_STRUCTS_BUFFERMETRICS_H
+#define CORAL_STRUCTS_BUFFERMETRICS_H
+
+#include "../ifgen/common.h"
+
+namespace Coral
+{
+
+struct [[gnu::packed]] BufferMetrics
+{
+    /* Constant attributes. */
+    static constexpr struct_id_t id = 2; /*!< BufferMetrics's identifier. */
+    static constexpr std::size_t size =
+        112; /*!< BufferMetrics's size in bytes. */
+
+    /* Fields. */
+    uint64_t timestamp_ns;
+    uint64_t capacity;
+    uint64_t element_size;
+    uint64_t data;
+    uint64_t high_watermark;
+    uint64_t write_total;
+    uint64_t read_total;
+    uint64_t dropped_full;
+    uint64_t dropped_oversize;
+    uint64_t dropped_evicted;
+    uint64_t data_callbacks;
+    uint64_t space_callbacks;
+    uint64_t data_suppressed;
+    uint64_t space_suppressed;
+
+    /* Methods. */
+    using Buffer = byte_array<size>;
+    using Span = byte_span<size>;
+
+    auto operator<=>(const BufferMetrics &) const = default;
+
+    /**
+     * Get this instance as a fixed-size byte array.
+     */
+    inline Buffer *raw()
+    {
+        return reinterpret_cast<Buffer *>(this);
+    }
+
+    /**
+     * Get this instance as a byte span.
+     */
+    inline Span span()
+    {
+        return Span(*raw());
+    }
+
+    /**
+     * Get this instance as a read-only fixed-size byte array.
+     */
+    inline const Buffer *raw_ro() const
+    {
+        return reinterpret_cast<const Buffer *>(this);
+    }
+
+    /**
+     * Handle swapping bytes for endian conversion (native).
+     *
+     * \tparam endianness Byte order for encoding elements.
+     */
+    template <std::endian endianness = default_endian>
+    inline void endian(void)
+        requires(endianness == std::endian::native)
+    {
+    }
+
+    /**
+     * Handle swapping bytes for endian conversion (swap required).
+     *
+     * \tparam endianness Byte order for encoding elements.
+     */
+    template <std::endian endianness = default_endian>
+    inline void endian(void)
+        requires(endianness != std::endian::native)
+    {
+        timestamp_ns = handle_endian<endianness>(timestamp_ns);
+        capacity = handle_endian<endianness>(capacity);
+        element_size = handle_endian<endianness>(element_size);
+        data = handle_endian<endianness>(data);
+        high_watermark = handle_endian<endianness>(high_watermark);
+        write_total = handle_endian<endianness>(write_total);
+        read_total = handle_endian<endianness>(read_total);
+        dropped_full = handle_endian<endianness>(dropped_full);
+        dropped_oversize = handle_endian<endianness>(dropped_oversize);
+        dropped_evicted = handle_endian<endianness>(dropped_evicted);
+        data_callbacks = handle_endian<endianness>(data_callbacks);
+        space_callbacks = handle_endian<endianness>(space_callbacks);
+        data_suppressed = handle_endian<endianness>(data_suppressed);
+        space_suppressed = handle_endian<endianness>(space_suppressed);
+    }
+
+    /**
+     * Encode this instance to a buffer.
+     *
+     * \tparam     endianness Byte order for encoding elements.
+     * \param[out] buffer     Buffer to write.
+     * \return                The number of bytes encoded.
+     */
+    template <std::endian endianness = default_endian>
+    inline std::size_t encode(Buffer *buffer) const
+    {
+        *buffer = *raw_ro();
+
+        reinterpret_cast<BufferMetrics *>(buffer)->endian<endianness>();
+
+        return size;
+    }
+
+    /**
+     * Update this instance from a buffer.
+     *
+     * \tparam    endianness Byte order from decoding elements.
+     * \param[in] buffer     Buffer to read.
+     * \return               The number of bytes decoded.
+     */
+    template <std::endian endianness = default_endian>
+    inline std::size_t decode(const Buffer *buffer)
+    {
+        *raw() = *buffer;
+
+        endian<endianness>();
+
+        return size;
+    }
+};
+
+static_assert(sizeof(BufferMetrics) == BufferMetrics::size);
+static_assert(ifgen_struct<BufferMetrics>);
+
+}; // namespace Coral
+
+#endif
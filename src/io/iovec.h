@@ -0,0 +1,61 @@
+/**
+ * \file
+ * \brief Vectored IO over ring-buffer regions.
+ */
+#pragma once
+
+/* toolchain */
+#include <span>
+#include <sys/uio.h>
+#include <type_traits>
+
+/* internal */
+#include "../buffer/RingSegments.h"
+
+namespace Coral
+{
+
+/**
+ * Describe ring-buffer regions (e.g. messages from
+ * MessageBuffer::get_messages) as iovecs, for writev, skipping empty
+ * segments. Stops at the first region that doesn't fit.
+ *
+ * \param[in]  views   The regions to describe.
+ * \param[in]  count   The number of regions.
+ * \param[out] iovecs  The iovecs to fill (two per region at most).
+ * \param[out] regions The number of regions described.
+ * \return             The number of iovecs filled.
+ */
+template <typename element_t>
+std::size_t gather_iovecs(const RingSegments<element_t> *views,
+                          std::size_t count, std::span<struct iovec> iovecs,
+                          std::size_t &regions)
+{
+    std::size_t used = 0;
+
+    for (regions = 0; regions < count; regions++)
+    {
+        const auto &view = views[regions];
+        std::size_t needed = std::size_t(not view.first.empty()) +
+                             std::size_t(not view.second.empty());
+        if (used + needed > iovecs.size())
+        {
+            break;
+        }
+
+        for (auto segment : {view.first, view.second})
+        {
+            if (not segment.empty())
+            {
+                iovecs[used].iov_base = const_cast<std::remove_cv_t<
+                    element_t> *>(segment.data());
+                iovecs[used].iov_len = segment.size_bytes();
+                used++;
+            }
+        }
+    }
+
+    return used;
+}
+
+} // namespace Coral